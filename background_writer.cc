@@ -0,0 +1,94 @@
+#include "background_writer.h"
+
+#include "eigen_utils.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <utility>
+
+using EigenUtils::write_matrix_to_file;
+
+//     BackgroundWriter     BackgroundWriter     BackgroundWriter     BackgroundWriter     BackgroundWriter
+
+BackgroundWriter::BackgroundWriter (int capacity)
+  : mCapacity(capacity < 1 ? 1 : capacity), mQueue(), mMutex(), mChanged(), mFinishing(false),
+    mLongest(0), mBytes(0.0), mWriteSeconds(0.0), mWaitSeconds(0.0), mThread()
+{
+  mThread = std::thread(&BackgroundWriter::run, this);
+}
+
+
+void
+BackgroundWriter::push (Job job)
+{
+  std::unique_lock<std::mutex> lock (mMutex);
+  if ((int) mQueue.size() >= mCapacity)
+  { auto start = std::chrono::steady_clock::now();
+    mChanged.wait(lock, [this] () { return (int) mQueue.size() < mCapacity; });
+    mWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  mQueue.push_back(std::move(job));
+  if ((int) mQueue.size() > mLongest) mLongest = (int) mQueue.size();
+  mChanged.notify_all();
+}
+
+
+void
+BackgroundWriter::run ()
+{
+  std::unique_lock<std::mutex> lock (mMutex);
+  while (true)
+  { mChanged.wait(lock, [this] () { return mFinishing || !mQueue.empty(); });
+    if (mQueue.empty()) return;                            // finishing
+    Job job (std::move(mQueue.front()));
+    mQueue.pop_front();
+    mChanged.notify_all();                                 // room for push
+    lock.unlock();
+    auto start = std::chrono::steady_clock::now();
+    const double bytes (job());
+    const double seconds (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    lock.lock();
+    mBytes += bytes;
+    mWriteSeconds += seconds;
+  }
+}
+
+
+void
+BackgroundWriter::finish ()
+{
+  if (!mThread.joinable()) return;
+  { std::lock_guard<std::mutex> guard (mMutex);
+    mFinishing = true;
+  }
+  mChanged.notify_all();
+  mThread.join();
+}
+
+
+//     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs
+
+namespace
+{
+  double
+  write_file (std::string name, ValuePlanes const& planes, ValuePlanes::Plane p)
+  { write_matrix_to_file(name, planes.matrix(p));
+    struct stat st;
+    return (stat(name.c_str(), &st) == 0) ? (double) st.st_size : 0.0;
+  }
+}
+
+
+BackgroundWriter::Job
+text_round_job (std::string stem, ValuePlanes const& planes, bool meansOnly)
+{
+  return [stem, planes, meansOnly] ()
+    { double bytes (0.0);
+      if (!meansOnly)
+      { bytes += write_file(stem + ".utility", planes, ValuePlanes::utility);
+	bytes += write_file(stem + ".row"    , planes, ValuePlanes::row);
+	bytes += write_file(stem + ".col"    , planes, ValuePlanes::col);
+      }
+      return bytes + write_file(stem + ".mean", planes, ValuePlanes::mean);
+    };
+}
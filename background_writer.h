@@ -0,0 +1,73 @@
+#ifndef _BACKGROUND_WRITER_H_
+#define _BACKGROUND_WRITER_H_
+
+#include "value_planes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/***********************************************************************************
+
+  Writes the path details of a round on an I/O thread while the solver moves
+  on to the next round.
+
+  A job writes the files of one round (from its own copy of the planes, since
+  the solver reuses them two rounds later) and returns the bytes written.
+  The queue holds at most capacity jobs; once full, push waits for the I/O
+  thread to take one, so that a disk slower than the solver bounds the
+  rounds held in memory rather than letting them pile up.  The writer counts
+  the time the I/O thread spends writing and the time the solver spends
+  waiting on a full queue.
+
+***********************************************************************************/
+
+class BackgroundWriter
+{
+ public:
+  typedef std::function<double()> Job;                     // returns bytes written
+
+ private:
+  const int               mCapacity;
+  std::deque<Job>         mQueue;
+  std::mutex              mMutex;
+  std::condition_variable mChanged;                        // job added or taken, or finishing
+  bool                    mFinishing;
+  int                     mLongest;                        // most jobs waiting
+  double                  mBytes;
+  double                  mWriteSeconds;                   // by the I/O thread
+  double                  mWaitSeconds;                    // by push on a full queue
+  std::thread             mThread;
+
+ public:
+
+  BackgroundWriter (int capacity);
+  ~BackgroundWriter() { finish(); }
+
+  BackgroundWriter (BackgroundWriter const&) = delete;
+  BackgroundWriter& operator=(BackgroundWriter const&) = delete;
+
+  void   push (Job job);
+  void   finish ();                                        // writes the jobs left, then stops the thread
+
+  // read once finished
+  int    longest_queue()      const { return mLongest; }
+  double megabytes()          const { return mBytes / (1024.0*1024.0); }
+  double write_seconds()      const { return mWriteSeconds; }
+  double wait_seconds()       const { return mWaitSeconds; }
+
+ private:
+  void   run ();
+};
+
+
+//  Job that writes the planes of a round as text files <stem>.utility, .row, .col and .mean,
+//  or only <stem>.mean
+
+BackgroundWriter::Job
+text_round_job (std::string stem, ValuePlanes const& planes, bool meansOnly);
+
+#endif
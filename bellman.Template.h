@@ -1,10 +1,22 @@
 #include "bellman.h"
 #include "utility.h"
 #include "line_search.h"
+#include "background_writer.h"
+#include "mean_search.Template.h"
+#include "parallel.Template.h"
+#include "path_archive.h"
+#include "special_functions.h"
+#include "stencil.h"
+#include "value_planes.h"
 
 #include <fstream>
 #include <iomanip>
 #include <ios>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <typeinfo>
+#include <utility>
 
 #include "eigen_utils.h"
 using EigenUtils::write_matrix_to_file;
@@ -15,12 +27,324 @@ using EigenUtils::write_matrix_to_file;
 
 Line_Search::GoldenSection make_search_engine(void);
 
-//
+
+//  State of the matrix recursion for one angle: the planes it flips between, the search optima
+//  of this round and the prior one, and per-thread copies of the utility and search engine
+//  (set_constants changes the utility).  A solve for several angles carries one of these per
+//  angle through the same rounds.  Once stationary, a sweep is done and skipped.  Values
+//  gives the precision of the planes and of the interpolation of their values.
+
+template<class Util, class Values = MixedValues>
+class MatrixSweep
+{
+ public:
+  typedef BasicValuePlanes<typename Values::Storage> Planes;
+
+ private:
+  Planes                   mPlanes0, mPlanes1;
+  bool                     mFlipped;
+
+ public:
+  std::vector<Util>        utilities;                               // by thread
+  std::vector<MeanSearch>  searches;
+  std::vector<double>      searchMean, priorSearchMean;             // by cell, stored by rows
+  std::vector<int>         searchRival;                             //   ... grid point of the other mode, kept across rounds
+  std::pair<double,double> bestMeanInterval;
+  std::unique_ptr<StationaryMonitor> monitor;
+  std::vector<HorizonValues> horizons;
+  MeanPolicy              *policy;                                  // hints from and for another solve, if any
+  bool                     done;
+
+  MatrixSweep (Util const& utility, int nRows, int nCols, int nRounds, SolverOptions const& options, MeanPolicy *pol = 0)
+    : mPlanes0(nRows,nCols), mPlanes1(nRows,nCols), mFlipped(false),
+      utilities(options.nThreads, utility), searches(options.nThreads, make_mean_search(options)),
+      searchMean(nRows*nCols, 0.0), priorSearchMean(nRows*nCols, 0.0), searchRival(nRows*nCols, -1),
+      bestMeanInterval(std::make_pair(10,0)),
+      monitor(make_stationary_monitor(nRounds, options)), horizons(), policy(pol), done(false) { }
+
+  Util const&        utility()     const { return utilities[0]; }
+  Planes const&      source()      const { return mFlipped ? mPlanes1 : mPlanes0; }
+  Planes      &      destination()       { return mFlipped ? mPlanes0 : mPlanes1; }
+
+  void flip() { mFlipped = !mFlipped; searchMean.swap(priorSearchMean); }   // destination becomes the source
+};
+
+
+//  Solves one cell of the matrix recursion for one angle, given the values v gathered from its
+//  source planes.  The optimum found by the search (before comparing to mu=0) goes into
+//  searchMean, stored by rows; the one found in the prior round is the hint for a warm start.
+//  searchRival keeps, from round to round, the grid point of the other mode that a hinted
+//  search must beat.
+//  For a monotone policy, the optima at (r-1,c) and (r,c-1) are hints when they lie in the
+//  same tile and so were solved earlier by the same thread, keeping results independent of
+//  the number of threads.  Given tables of the rejection curves, the utility is maximized over
+//  the grid of the tables instead, optionally refined by a local search around the best mean.
+//  Given bounds on the curves, cells whose utility is bounded below its value at mu=0 skip
+//  the search; such cells have no search optimum (0 in searchMean).  Lacking other hints, the
+//  optimum at the cell in a prior solve is the hint, given its policy.
+
+template<class Util, class Planes>
+void
+solve_bellman_matrix_cell (Util &utility, MeanSearch &search, TransitionStencil const& stencil, TransitionStencil::Tile const& tile,
+			   int r, int c, double const* v, Planes &dest,
+			   std::vector<double> const& priorSearchMean, std::vector<double> &searchMean, std::vector<int> &searchRival,
+			   double policyMean,
+			   RejectionCurves const* curves, RejectionBounds const* rowBounds, RejectionBounds const* colBounds,
+			   SolverOptions const& options)
+{
+  const int nCols (stencil.cols());
+  const int k (r*nCols+c);
+  std::pair<double,double> maxPair;                                     // x,f(x)
+  utility.set_constants(stencil.row_bid(r), stencil.col_bid(c), v[0], v[1], v[2], v[3]);
+  int j (-1);                                                           // index of opt mu in tables, if there
+  const CurveWeights w (utility.curve_weights());
+  const double utilAtMuEqualZero (curves ? curves->value(w, r, c, 0) : utility(0.0));
+  if (rowBounds && (rowBounds->upper_bound(w, r, *colBounds, c) < utilAtMuEqualZero))
+  { search.count_pruned();                                              // no mean in the interval beats mu=0
+    maxPair = std::make_pair(0.0, utilAtMuEqualZero);
+    if (curves) j = 0;
+  }
+  else if (curves)
+  { std::pair<int,double> best (curves->argmax(w, r, c));
+    const double mu (curves->mean(best.first)), step (curves->grid_step());
+    if (options.refineTable)
+      maxPair = search.refine_maximum(utility, mu-step, mu, mu+step);
+    else
+    { maxPair = std::make_pair(mu, best.second);
+      j = best.first;
+    }
+  }
+  else
+  { MeanHint hint;
+    if (options.warmStart)                   hint.add(priorSearchMean[k]);
+    if (options.monotone && (tile.r0 < r))   hint.add(searchMean[k-nCols]);
+    if (options.monotone && (tile.c0 < c))   hint.add(searchMean[k-1]);
+    if (options.policyHints && hint.empty()) hint.add(policyMean);     // 0 is not a hint
+    maxPair = search.find_maximum(utility, hint.lo(), hint.hi(), &searchRival[k]);   // returns opt, f(opt)
+  }
+  searchMean[k] = maxPair.first;                                        // 0 if pruned
+  if (maxPair.second < utilAtMuEqualZero)
+  { maxPair = std::make_pair(0.0,utilAtMuEqualZero);
+    if (curves) j = 0;
+  }
+  if (0 <= j)
+    dest.set(r, c, maxPair.second,
+	     curves->value(utility.row_weights(v[4], v[5], v[6], v[ 7]), r, c, j),
+	     curves->value(utility.col_weights(v[8], v[9], v[10],v[11]), r, c, j),
+	     maxPair.first);
+  else
+    dest.set(r, c, maxPair.second,
+	     utility.row_utility(maxPair.first, v[4], v[5], v[6], v[ 7]),  // opt mu
+	     utility.col_utility(maxPair.first, v[8], v[9], v[10],v[11]),
+	     maxPair.first);
+}
+
+
+//  One backward step of the matrix recursion for each sweep not yet done, filling its
+//  destination planes from its source planes.  Cells within a round read only the sources,
+//  so the tiles of the stencil are spread over the threads of the pool, which the solve keeps
+//  for all its rounds.  The stencil supplies bids and the interpolation of the sources at the
+//  positions after the round; a cell gathers from the sources of all sweeps at once, and the
+//  tables and bounds of the rejection curves serve every sweep.  Given the states reachable
+//  from the start, cells not reached in this round (counted from the start) are skipped and
+//  hold zero.
+
+template<class Util, class Values>
+void
+solve_bellman_matrix_round (std::vector<MatrixSweep<Util,Values>*> const& allSweeps, TransitionStencil const& stencil,
+			    RejectionCurves const* curves, RejectionBounds const* rowBounds, RejectionBounds const* colBounds,
+			    ReachableStates const* rowStates, ReachableStates const* colStates, int round,
+			    WorkerPool &pool, SolverOptions const& options)
+{
+  std::vector<MatrixSweep<Util,Values>*> sweeps;
+  std::vector<typename MatrixSweep<Util,Values>::Planes const*> sources;
+  for (MatrixSweep<Util,Values>* s : allSweeps)
+    if (!s->done)
+    { sweeps.push_back(s);
+      sources.push_back(&s->source());
+    }
+  const int nSweeps ((int) sweeps.size());
+  const int nCols (stencil.cols());
+  std::vector<TransitionStencil::Tile> const& tiles (stencil.tiles());
+  parallel_for((int) tiles.size(), pool, [&] (int thread, int t)
+  { TransitionStencil::Tile const& tile (tiles[t]);
+    std::vector<double> v (12*nSweeps);                                 // v00, v01, v10, v11 for utility, row, col by sweep
+    int cell (tile.firstCell);
+    for (int r=tile.r0; r<tile.r1; ++r)
+      for (int c=tile.c0; c<tile.c1; ++c, ++cell)                         // padding... allows zero weight on zero value without if/else
+      { if (rowStates && !(rowStates->reached(round,r) && colStates->reached(round,c)))
+	{ for (MatrixSweep<Util,Values>* s : sweeps)                      // not reached from the start
+	  { s->searchMean[r*nCols+c] = 0.0;
+	    s->destination().set(r, c, 0.0, 0.0, 0.0, 0.0);
+	  }
+	  continue;
+	}
+	stencil.gather<typename Values::Accumulate>(cell, nSweeps, &sources[0], &v[0]);
+	for (int i=0; i<nSweeps; ++i)
+	{ MatrixSweep<Util,Values> &s (*sweeps[i]);
+	  const double policyMean ((s.policy && s.policy->has(round)) ? s.policy->mean(round, r*nCols+c) : 0.0);
+	  solve_bellman_matrix_cell(s.utilities[thread], s.searches[thread], stencil, tile, r, c, &v[12*i], s.destination(),
+				    s.priorSearchMean, s.searchMean, s.searchRival, policyMean, curves, rowBounds, colBounds, options);
+	}
+      }
+  });
+}
+
+
+inline
+SearchStats
+total_search_stats (std::vector<MeanSearch> const& searches)
+{
+  SearchStats stats;
+  for (MeanSearch const& s : searches)
+    stats += s.stats();
+  return stats;
+}
+
+
+//  Monitor range of optimal means; folded in row order after each round so that the result
+//  does not depend on how the cells were spread over threads.  Pruned cells have no optimum.
+
+inline
+void
+update_mean_interval (std::pair<double,double> &interval, std::vector<double> const& searchMean, int nRows, int nCols)
+{
+  for (int r=0; r<nRows-1; ++r)
+    for (int c=0; c<nCols-1; ++c)
+    { double mu (searchMean[r*nCols+c]);
+      if (mu <= 0.0)
+	continue;
+      if(mu < interval.first)
+	interval.first = mu;
+      else if (mu > interval.second)
+	interval.second = mu;
+    }
+}
+
+
+template<class Planes>
+HorizonValues
+zero_index_values (Planes const& planes, std::pair<int,int> zeroIndex)
+{
+  HorizonValues v = { planes(zeroIndex.first, zeroIndex.second, ValuePlanes::utility),
+		      planes(zeroIndex.first, zeroIndex.second, ValuePlanes::row    ),
+		      planes(zeroIndex.first, zeroIndex.second, ValuePlanes::col    ) };
+  return v;
+}
+
 
 template<class Util>
+std::string
+matrix_config (Util const& utility, DualWealthArray const& rowWealth, DualWealthArray const& colWealth)
+{
+  std::ostringstream ss;
+  ss << std::setprecision(8) << utility.identifier() << " " << 1000*rowWealth.omega()+colWealth.omega();
+  return ss.str();
+}
+
+//  After the last round solved, writes the searches of a sweep to the log and returns its summary
+
+template<class Util, class Values>
+AngleSummary
+summarize_matrix_sweep (MatrixSweep<Util,Values> &sweep, int nRounds, DualWealthArray const& rowWealth,  DualWealthArray const& colWealth)
+{
+  const std::pair<int,int> zeroIndex(std::make_pair(rowWealth.zero_index(), colWealth.zero_index()));
+  std::clog << "BELL: Optimal means found in [" << sweep.bestMeanInterval.first << "," << sweep.bestMeanInterval.second << "]" << std::endl;
+  std::clog << "BELL: Search for means: " << total_search_stats(sweep.searches) << std::endl;
+  if (sweep.monitor)
+  { extrapolate_horizons(*sweep.monitor, sweep.horizons, nRounds);
+    std::clog << "BELL: Mean at the start in the last round solved is "
+	      << sweep.source()(zeroIndex.first, zeroIndex.second, ValuePlanes::mean) << std::endl;
+  }
+  AngleSummary summary = { matrix_config(sweep.utility(), rowWealth, colWealth), sweep.horizons };
+  return summary;
+}
+
+
+//  After a round (counted from the start), folds the results of a sweep into its summaries and flips its planes
+
+template<class Util, class Values>
 void
-solve_bellman_matrix_utility (int nRounds, Util &utility,
-			      DualWealthArray const& rowWealth,  DualWealthArray const& colWealth)
+finish_matrix_round (MatrixSweep<Util,Values> &sweep, std::pair<int,int> zeroIndex, int round)
+{
+  const int nRows (sweep.source().rows()), nCols (sweep.source().cols());
+  update_mean_interval(sweep.bestMeanInterval, sweep.searchMean, nRows, nCols);
+  sweep.horizons.push_back(zero_index_values(sweep.destination(), zeroIndex));
+  sweep.done = sweep.monitor && sweep.monitor->update(sweep.source(), sweep.destination(), zeroIndex);
+  if (sweep.policy) sweep.policy->store(round, sweep.searchMean);
+  sweep.flip();
+}
+
+
+//  Saves the state of a sweep after the given number of rounds, counted back from the end.
+//  Once flipped, the prior search optima are those of the round just solved.
+
+template<class Util, class Values>
+void
+save_checkpoint (MatrixSweep<Util,Values> const& sweep, std::string const& key, int steps)
+{
+  MatrixCheckpoint checkpoint (key, sweep.source().rows(), sweep.source().cols());
+  checkpoint.steps = steps;
+  checkpoint.planes.assign(sweep.source());
+  checkpoint.searchMean = sweep.priorSearchMean;
+  checkpoint.meanInterval = sweep.bestMeanInterval;
+  for (HorizonValues const& v : sweep.horizons)
+  { checkpoint.horizons.push_back(v.utility);
+    checkpoint.horizons.push_back(v.row);
+    checkpoint.horizons.push_back(v.col);
+  }
+  checkpoint.write(checkpoint_file(key));
+}
+
+
+//  Restores the sweeps from their checkpoints, as if they had solved the rounds saved; returns
+//  the number of rounds restored, 0 unless every sweep has a checkpoint after the same number
+//  of rounds, at most nRounds
+
+template<class Util, class Values>
+int
+resume_from_checkpoints (std::vector<MatrixSweep<Util,Values>*> const& sweeps, std::vector<std::string> const& keys, int nRounds)
+{
+  std::vector<std::unique_ptr<MatrixCheckpoint>> checkpoints;
+  for (int i=0; i<(int)sweeps.size(); ++i)
+  { checkpoints.emplace_back(new MatrixCheckpoint(keys[i], sweeps[i]->source().rows(), sweeps[i]->source().cols()));
+    if (!checkpoints.back()->read(checkpoint_file(keys[i])))
+    { std::clog << "BELL: No checkpoint for " << keys[i] << "; solving from the end." << std::endl;
+      return 0;
+    }
+    if (checkpoints.back()->steps != checkpoints.front()->steps)
+    { std::clog << "BELL: Checkpoints of the angles hold different numbers of rounds; solving from the end." << std::endl;
+      return 0;
+    }
+  }
+  const int steps (checkpoints.empty() ? 0 : checkpoints.front()->steps);
+  if (nRounds < steps)
+  { std::clog << "BELL: Checkpoint holds " << steps << " rounds, more than the " << nRounds << " asked for; solving from the end." << std::endl;
+    return 0;
+  }
+  for (int i=0; i<(int)sweeps.size(); ++i)
+  { MatrixSweep<Util,Values> &s (*sweeps[i]);
+    MatrixCheckpoint const& checkpoint (*checkpoints[i]);
+    s.destination().assign(checkpoint.planes);
+    s.searchMean = checkpoint.searchMean;
+    s.bestMeanInterval = checkpoint.meanInterval;
+    s.horizons.clear();
+    for (int h=0; h<steps; ++h)
+    { HorizonValues v = { checkpoint.horizons[3*h], checkpoint.horizons[3*h+1], checkpoint.horizons[3*h+2] };
+      s.horizons.push_back(v);
+    }
+    s.flip();
+  }
+  std::clog << "BELL: Resuming from checkpoints after " << steps << " of " << nRounds << " rounds" << std::endl;
+  return steps;
+}
+
+
+template<class Util, class Values>
+std::vector<AngleSummary>
+solve_bellman_matrix_sweeps (int nRounds, std::vector<Util> const& utilities,
+			     DualWealthArray const& rowWealth,  DualWealthArray const& colWealth, SolverOptions const& options,
+			     std::vector<MeanPolicy> *policies)
 {
   //  std::clog << "BELL: Space conserving matrix  version being used to find Bellman matrix utility, Eigen " <<  EigenUtils::version() << std::endl;
   
@@ -28,162 +352,188 @@ solve_bellman_matrix_utility (int nRounds, Util &utility,
   const int nCols (1+colWealth.number_wealth_positions());
   const std::pair<int,int> zeroIndex(std::make_pair(rowWealth.zero_index(), colWealth.zero_index()));
   std::clog << "BELL: Zero indices are " << zeroIndex.first << " & " << zeroIndex.second << std::endl;
-  // code flips between these on read and write using use0
-  bool use0 = true;
-  Matrix  utilityMat0= Matrix::Zero (nRows, nCols);                       // initialize with zero for risk, 1 for rejection
-  Matrix  utilityMat1= Matrix::Zero (nRows, nCols);
-  Matrix* pUtilitySrc(&utilityMat0), *pUtilityDest(&utilityMat1);
-  Matrix  rowMat0    = Matrix::Zero (nRows, nCols);
-  Matrix  rowMat1    = Matrix::Zero (nRows, nCols);
-  Matrix* pRowSrc(&rowMat0), *pRowDest(&rowMat1);
-  Matrix  colMat0    = Matrix::Zero (nRows, nCols);
-  Matrix  colMat1    = Matrix::Zero (nRows, nCols);
-  Matrix* pColSrc(&colMat0 ), *pColDest(&colMat1);
-  // iteration vars
-  std::pair<double,double> maxPair;                                       // x,f(x)
-  std::pair<double,double> bestMeanInterval = std::make_pair(10,0);
-  auto search = make_search_engine();
-  for (int round = nRounds; 0 < round; --round)
-  { if (use0)   // flip progress arrays
-    { pUtilitySrc = &utilityMat0;    pRowSrc  = &rowMat0;   pColSrc  = &colMat0;
-      pUtilityDest= &utilityMat1;    pRowDest = &rowMat1;   pColDest = &colMat1;
-    } else
-    { pUtilitySrc = &utilityMat1;    pRowSrc  = &rowMat1;   pColSrc  = &colMat1;
-      pUtilityDest= &utilityMat0;    pRowDest = &rowMat0;   pColDest = &colMat0;
-    }
-    use0 = !use0;
-    for (int r=0; r<nRows-1; ++r)                                         //  padding... allows zero weight on zero value without if/else
-    { double rowBid = rowWealth.bid(r);
-      std::pair<int, double> rowBidPos    = rowWealth.bid_position(r);    // if does not reject
-      std::pair<int, double> rowRejectPos = rowWealth.reject_position(r); // if rejects
-      for (int c=0; c<nCols-1; ++c) 
-      { double colBid = colWealth.bid(c);
-	std::pair<int, double>  colBidPos   (colWealth.bid_position(c));
-	std::pair<int, double> colRejectPos (colWealth.reject_position(c));
-	utility.set_constants(rowBid, colBid,
-			      reject_value ( rowBidPos  ,  colBidPos  , *pUtilitySrc),   // v00  neither rejects; wealth function is decreasing
-			      reject_value ( rowBidPos  , colRejectPos, *pUtilitySrc),   // v01  only column player rejects
-			      reject_value (rowRejectPos,  colBidPos  , *pUtilitySrc),   // v10  only row rejects
-			      reject_value (rowRejectPos, colRejectPos, *pUtilitySrc));  // v11  both reject
-	maxPair = search.find_maximum(utility);       // returns opt, f(opt)
-	// monitor range of optimal means
-	if(maxPair.first < bestMeanInterval.first)
-	  bestMeanInterval.first = maxPair.first;
-	else if (maxPair.first > bestMeanInterval.second)
-	  bestMeanInterval.second = maxPair.first;	
-	double utilAtMuEqualZero = utility(0.0);
-	if (maxPair.second < utilAtMuEqualZero)
-	  maxPair = std::make_pair(0.0,utilAtMuEqualZero);
-	(*pUtilityDest)(r,c) = maxPair.second;
-	(* pRowDest)(r,c) = utility.row_utility(maxPair.first,                                            // opt mu
-						   reject_value (rowBidPos   ,  colBidPos  , *pRowSrc),   // v00  neither rejects
-						   reject_value (rowBidPos   , colRejectPos, *pRowSrc),   // v01  only column player rejects
-						   reject_value (rowRejectPos,  colBidPos  , *pRowSrc),   // v10  only row rejects
-						   reject_value (rowRejectPos, colRejectPos, *pRowSrc));  // v11  both reject
-        (* pColDest)(r,c) = utility.col_utility(maxPair.first,
-						   reject_value (rowBidPos   ,  colBidPos  , *pColSrc),   // v00  neither rejects
-						   reject_value (rowBidPos   , colRejectPos, *pColSrc),   // v01  only column player rejects
-						   reject_value (rowRejectPos,  colBidPos  , *pColSrc),   // v10  only row rejects
-						   reject_value (rowRejectPos, colRejectPos, *pColSrc));  // v11  both reject
+  if (1 < utilities.size())
+    std::clog << "BELL: Solving " << utilities.size() << " angles in one sweep" << std::endl;
+  // one sweep per angle, sharing the stencil, tables, bounds and reachable states
+  std::vector<std::unique_ptr<MatrixSweep<Util,Values>>> owned;
+  std::vector<MatrixSweep<Util,Values>*> sweeps;
+  if (policies) policies->resize(utilities.size());
+  for (int i=0; i<(int)utilities.size(); ++i)
+  { owned.emplace_back(new MatrixSweep<Util,Values>(utilities[i], nRows, nCols, nRounds, options, policies ? &(*policies)[i] : 0));
+    sweeps.push_back(owned.back().get());
+  }
+  const std::shared_ptr<const TransitionStencil> stencil (shared_stencil(rowWealth, colWealth, sizeof(typename Values::Storage), options));
+  const std::shared_ptr<const RejectionCurves>   curves  (shared_rejection_curves(rowWealth, colWealth, options));
+  const std::unique_ptr<RejectionBounds> rowBounds (make_rejection_bounds(bids_of(rowWealth), options));
+  const std::unique_ptr<RejectionBounds> colBounds (make_rejection_bounds(bids_of(colWealth), options));
+  const std::unique_ptr<ReachableStates> rowStates (make_reachable_states(rowWealth, nRounds, options));
+  const std::unique_ptr<ReachableStates> colStates (make_reachable_states(colWealth, nRounds, options));
+  WorkerPool pool (options.nThreads);                                     // threads of every round
+  // checkpoints of each sweep, keyed by its utility, the options that change the values found and the
+  // wealth arrays, so that a resume under other options starts afresh; rounds restored are not solved again
+  const bool checkpoints (use_checkpoints(options, policies != 0));
+  std::ostringstream solveOptions;
+  solveOptions << std::setprecision(17) << " table " << options.tableStep << (options.refineTable ? " refine" : "")
+	       << (options.newton ? " newton" : "") << " accuracy " << Special::name(Special::accuracy())
+	       << " precision " << precision_name(options.precision);
+  std::vector<std::string> keys;
+  for (MatrixSweep<Util,Values>* s : sweeps)
+    keys.push_back(checkpoint_key(typeid(Util).name() + std::string(" ") + s->utility().identifier() + solveOptions.str(),
+				  rowWealth, colWealth));
+  const int first (nRounds - ((checkpoints && options.resume) ? resume_from_checkpoints(sweeps, keys, nRounds) : 0));
+  for (int round = first; (0 < round) && !cancelled(options); --round)
+  { solve_bellman_matrix_round(sweeps, *stencil, curves.get(), rowBounds.get(), colBounds.get(),
+			       rowStates.get(), colStates.get(), round-1, pool, options);
+    bool allDone (true);
+    for (MatrixSweep<Util,Values>* s : sweeps)
+      if (!s->done)
+      { finish_matrix_round(*s, zeroIndex, round-1);
+	allDone = allDone && s->done;
       }
-    }
+    const int steps (nRounds - round + 1);
+    if (checkpoints && (0 < options.checkpointEvery) && ((1 == round) || (0 == steps % options.checkpointEvery)))
+      for (int i=0; i<(int)sweeps.size(); ++i)
+	save_checkpoint(*sweeps[i], keys[i], steps);
+    if (allDone) break;
+  }
+  if (rowStates)
+    std::clog << "BELL: Reachable states: skipped " << 100*fraction_skipped(*rowStates, *colStates) << "% of "
+	      << (long) nRounds*(nRows-1)*(nCols-1) << " cells" << std::endl;
+  std::vector<AngleSummary> summaries;
+  for (MatrixSweep<Util,Values>* s : sweeps)
+    summaries.push_back(summarize_matrix_sweep(*s, nRounds, rowWealth, colWealth));
+  return summaries;
+}
+
+
+template<class Util>
+std::vector<AngleSummary>
+solve_bellman_matrix_utilities (int nRounds, std::vector<Util> const& utilities,
+				DualWealthArray const& rowWealth,  DualWealthArray const& colWealth, SolverOptions const& options,
+				std::vector<MeanPolicy> *policies)
+{
+  if (SolverOptions::mixedValues != options.precision)
+    std::clog << "BELL: Solving with " << precision_name(options.precision) << " precision values." << std::endl;
+  switch (options.precision)
+  {
+  case SolverOptions::floatValues:
+    return solve_bellman_matrix_sweeps<Util, FloatValues >(nRounds, utilities, rowWealth, colWealth, options, policies);
+  case SolverOptions::doubleValues:
+    return solve_bellman_matrix_sweeps<Util, DoubleValues>(nRounds, utilities, rowWealth, colWealth, options, policies);
+  default:
+    return solve_bellman_matrix_sweeps<Util, MixedValues >(nRounds, utilities, rowWealth, colWealth, options, policies);
   }
+}
+
+
+template<class Util>
+void
+solve_bellman_matrix_utility (int nRounds, Util &utility,
+			      DualWealthArray const& rowWealth,  DualWealthArray const& colWealth, SolverOptions const& options)
+{
+  std::vector<AngleSummary> summary (solve_bellman_matrix_utilities(nRounds, std::vector<Util>(1, utility), rowWealth, colWealth, options));
   // write configuration and results to stdio
-  std::cout << std::setprecision(8)
-	    << utility.identifier() << " " << 1000*rowWealth.omega()+colWealth.omega() << "   " << nRounds   << "   " 
-	    << (*pUtilityDest)(zeroIndex.first, zeroIndex.second) << " "
-	    << (*pRowDest    )(zeroIndex.first, zeroIndex.second) << " "
-	    << (*pColDest    )(zeroIndex.first, zeroIndex.second) << std::endl;
+  write_horizons(std::cout, summary[0].config, summary[0].horizons, options.allHorizons);
 }
 
 
 template<class Util>
 void
 solve_bellman_matrix_utility (int nRounds, Util &utility,
-			      DualWealthArray const& rowWealth,  DualWealthArray const& colWealth, std::string config, bool writePathDetails)
+			      DualWealthArray const& rowWealth,  DualWealthArray const& colWealth, std::string config, bool writePathDetails,
+			      SolverOptions const& options)
 {
   std::clog << "BELL: Tensor version being used to solve for Bellman matrix utility, Eigen " /* << EigenUtils::version() */ << std::endl;
+  if (SolverOptions::mixedValues != options.precision)
+    std::clog << "BELL: Tensor version keeps float planes for its path details; solving with mixed precision." << std::endl;
   
   const int nRows (1+rowWealth.number_wealth_positions());                // extra 1 for padding; allow 0 * 0
   const int nCols (1+colWealth.number_wealth_positions());
   const std::pair<int,int> zeroIndex(std::make_pair(rowWealth.zero_index(), colWealth.zero_index()));
   std::clog << "BELL: Zero indices are " << zeroIndex.first << " & " << zeroIndex.second << std::endl;
-  // represent tensor structure as vector of matrices
-  typedef std::vector<Matrix> MatrixVec;
-  MatrixVec utilityMat(1+nRounds), rowMat(1+nRounds), colMat(1+nRounds);
-  for(int r=0; r <=nRounds; ++r)
-  { utilityMat[r] = Matrix::Zero(nRows,nCols);
-    rowMat[r]     = Matrix::Zero(nRows,nCols);
-    colMat[r]     = Matrix::Zero(nRows,nCols);
-  }
-  MatrixVec meanMat(1+nRounds);                                           // hold space for path
-  { int useRows = writePathDetails ? nRows : 1;                           // small placeholder used if no space needed
-    int useCols = writePathDetails ? nCols : 1;
-    for(int r=0; r <=nRounds; ++r)
-      meanMat[r] = Matrix::Zero(useRows, useCols);
-  }
-  // iteration vars
-  std::pair<double,double> maxPair;                                       // x,f(x)
-  std::pair<double,double> bestMeanInterval = std::make_pair(10,0);
-  auto search = make_search_engine();
+  // write the path details of each round once it is done, on an I/O thread unless the options turn it off:
+  // text files or an archive, holding all planes or only the means if memory is bounded.  A bounded solve
+  // that neither spills nor archives keeps the means in a PolicyStore and writes them at the end.
+  const bool archived (writePathDetails && options.archivePath);
+  const bool bounded (writePathDetails && options.boundedMemory);
+  const bool stored (bounded && !options.spillRounds && !archived);
+  const std::string path ("sim_details/");
+  std::unique_ptr<PathArchiveWriter> archive (archived
+					      ? new PathArchiveWriter(path + config + ".bellpath", config, nRounds, nRows, nCols,
+								      options.boundedMemory, rowWealth, colWealth) : 0);
+  const double searchTolerance (0.0001);                                  // as in make_mean_search
+  std::unique_ptr<PolicyStore> policy (stored ? new PolicyStore(nRounds, options.quantizePolicy, searchTolerance) : 0);
+  std::unique_ptr<BackgroundWriter> writer ((writePathDetails && !stored) ? make_background_writer(options) : 0);
+  if (writePathDetails && !archived)
+    std::clog << "BELL: Writing path details into directory " << path << config
+	      << (bounded ? " with files .mean only" : " with files .utility, .row, .col, and .mean") << std::endl;
+  MatrixSweep<Util> sweep (utility, nRows, nCols, nRounds, options);
+  const std::vector<MatrixSweep<Util>*> sweeps (1, &sweep);
+  const TransitionStencil stencil (rowWealth, colWealth);
+  const std::unique_ptr<RejectionCurves> curves (make_rejection_curves(rowWealth, colWealth, options));
+  const std::unique_ptr<RejectionBounds> rowBounds (make_rejection_bounds(bids_of(rowWealth), options));
+  const std::unique_ptr<RejectionBounds> colBounds (make_rejection_bounds(bids_of(colWealth), options));
+  const std::unique_ptr<ReachableStates> rowStates (make_reachable_states(rowWealth, nRounds, options));
+  const std::unique_ptr<ReachableStates> colStates (make_reachable_states(colWealth, nRounds, options));
+  WorkerPool pool (options.nThreads);                                     // threads of every round
   for (int round = nRounds; 0 < round; --round)
-  { Matrix *pUtilitySrc = &utilityMat[round  ], *pRowSrc  = & rowMat[round  ], *pColSrc  = & colMat[round  ];
-    Matrix *pUtilityDest= &utilityMat[round-1], *pRowDest = & rowMat[round-1], *pColDest = & colMat[round-1];
-    Matrix *pMeanMat = &meanMat[round-1];
-    for(int r=0; r<nRows-1; ++r)                                          //  padding... allows zero weight on zero value without if/else
-    { double rowBid = rowWealth.bid(r);
-      std::pair<int, double> rowBidPos    = rowWealth.bid_position(r);    // if does not reject
-      std::pair<int, double> rowRejectPos = rowWealth.reject_position(r); // if rejects
-      for (int c=0; c<nCols-1; ++c) 
-      { double colBid = colWealth.bid(c);
-	std::pair<int, double>  colBidPos   (colWealth.bid_position(c));
-	std::pair<int, double> colRejectPos (colWealth.reject_position(c));
-	utility.set_constants(rowBid, colBid,
-			      reject_value ( rowBidPos  ,  colBidPos  , *pUtilitySrc),   // v00  neither rejects; wealth function is decreasing
-			      reject_value ( rowBidPos  , colRejectPos, *pUtilitySrc),   // v01  only column player rejects
-			      reject_value (rowRejectPos,  colBidPos  , *pUtilitySrc),   // v10  only row rejects
-			      reject_value (rowRejectPos, colRejectPos, *pUtilitySrc));  // v11  both reject
-	maxPair = search.find_maximum(utility);       // returns opt, f(opt)
-	// monitor range of optimal means
-	if(maxPair.first < bestMeanInterval.first)
-	  bestMeanInterval.first = maxPair.first;
-	else if (maxPair.first > bestMeanInterval.second)
-	  bestMeanInterval.second = maxPair.first;	
-	double utilAtMuEqualZero = utility(0.0);
-	if (maxPair.second < utilAtMuEqualZero)  maxPair = std::make_pair(0.0,utilAtMuEqualZero);
-	if(writePathDetails)
-	  (* pMeanMat)(r,c) = maxPair.first;
-	(* pUtilityDest)(r,c) = maxPair.second;
-	(* pRowDest)(r,c) = utility.row_utility(maxPair.first,                                            // opt mu
-						reject_value (rowBidPos   ,  colBidPos  , *pRowSrc),   // v00  neither reject
-						reject_value (rowBidPos   , colRejectPos, *pRowSrc),   // v01  only column player rejects
-						reject_value (rowRejectPos,  colBidPos  , *pRowSrc),   // v10  only row rejects
-						reject_value (rowRejectPos, colRejectPos, *pRowSrc));  // v11  both reject
-        (* pColDest)(r,c) = utility.col_utility(maxPair.first,
-						reject_value (rowBidPos   ,  colBidPos  , *pColSrc),   // v00  neither rejects
-						reject_value (rowBidPos   , colRejectPos, *pColSrc),   // v01  only column player rejects
-						reject_value (rowRejectPos,  colBidPos  , *pColSrc),   // v10  only row rejects
-						reject_value (rowRejectPos, colRejectPos, *pColSrc));  // v11  both reject
+  { solve_bellman_matrix_round(sweeps, stencil, curves.get(), rowBounds.get(), colBounds.get(),
+			       rowStates.get(), colStates.get(), round-1, pool, options);
+    ValuePlanes const& dest (sweep.destination());
+    if (policy)
+      policy->put(round-1, dest);
+    else if (writePathDetails)
+    { BackgroundWriter::Job job;
+      if (archive)
+      { PathArchiveWriter *a (archive.get());
+	const int r (round-1);
+	const ValuePlanes planes (dest);
+	job = [a, r, planes] () { a->put(r, planes); return a->round_bytes(); };
       }
+      else
+	job = text_round_job(path + config + "_" + std::to_string(round-1), dest, bounded);
+      if (writer)
+	writer->push(std::move(job));
+      else
+	job();
     }
+    finish_matrix_round(sweep, zeroIndex, round-1);
+    if (sweep.done) break;
+  }
+  if (rowStates)
+    std::clog << "BELL: Reachable states: skipped " << 100*fraction_skipped(*rowStates, *colStates) << "% of "
+	      << (long) nRounds*(nRows-1)*(nCols-1) << " cells" << std::endl;
+  if (policy)
+  { std::clog << "BELL: Bounded memory kept the mean policy in " << policy->bytes() / (1024.0*1024.0) << " MB";
+    if (options.quantizePolicy)
+      std::clog << ", quantized with largest error " << policy->max_error() << " (" << policy->plain_rounds() << " rounds kept as floats)";
+    std::clog << std::endl;
   }
+  std::clog << "BELL: Peak resident set size " << peak_resident_mb() << " MB" << std::endl;
   // write summary of configuration and results to stdio
-  std::cout << std::setprecision(8)
-	    << utility.identifier() << " " << 1000*rowWealth.omega()+colWealth.omega() << "   " << nRounds   << "   " 
-	    << utilityMat[0](zeroIndex.first, zeroIndex.second) << " "
-	    << rowMat[0]    (zeroIndex.first, zeroIndex.second) << " "
-	    << colMat[0]    (zeroIndex.first, zeroIndex.second) << std::endl;  
+  const AngleSummary summary (summarize_matrix_sweep(sweep, nRounds, rowWealth, colWealth));
+  write_horizons(std::cout, summary.config, summary.horizons, options.allHorizons);
   // write out matrices that hold path
-  if(writePathDetails)
-  { std::string path = "sim_details/";
-    std::clog << "BELL: Writing path details into directory " << path << config << " with files .utility, .row, and .col" << std::endl;
-    for (int round=0; round<nRounds; ++round)
-    { std::string sr = "_" + std::to_string(round);
-      write_matrix_to_file(path + config + sr + ".utility", utilityMat[round]);
-      write_matrix_to_file(path + config + sr + ".row"    , rowMat[round]);
-      write_matrix_to_file(path + config + sr + ".col"    , colMat[round]);
-      write_matrix_to_file(path + config + sr + ".mean"   , meanMat[round]);
-    }
+  if (writer)
+  { writer->finish();
+    std::clog << "BELL: Background writer wrote " << writer->megabytes() << " MB in " << writer->write_seconds() << " sec ("
+	      << writer->megabytes() / std::max(1.0e-9, writer->write_seconds()) << " MB/sec); solver waited "
+	      << writer->wait_seconds() << " sec, with at most " << writer->longest_queue() << " rounds queued" << std::endl;
+  }
+  if (archive)
+  { if (sweep.monitor)                                                    // policy of the last round solved
+      archive->put_stationary(sweep.source());
+    if (archive->close())
+      std::clog << "BELL: Wrote path details to " << path << config << ".bellpath, " << archive->megabytes() << " MB of rounds in "
+		<< archive->seconds() << " sec (" << archive->megabytes() / std::max(1.0e-9, archive->seconds()) << " MB/sec)" << std::endl;
+  }
+  else if(writePathDetails)
+  { if (policy)
+      for (int round=0; round<nRounds; ++round)
+	if (policy->has(round))
+	  write_matrix_to_file(path + config + "_" + std::to_string(round) + ".mean", policy->mean(round));
+    if (sweep.monitor)                                                    // policy of the last round solved
+      write_matrix_to_file(path + config + ".stationary_mean", sweep.source().matrix(ValuePlanes::mean));
     // write details of wealth functions
     { std::ios_base::openmode mode = std::ios_base::trunc;
       std::ofstream output (path + config + ".row_wealth", mode);
@@ -1,16 +1,23 @@
 #include "bellman.h"
 #include "random.h"
 #include "line_search.Template.h"
+#include "mean_search.Template.h"
+#include "utility.Template.h"
+#include "parallel.Template.h"
 #include "wealth.h"
+#include "stencil.h"
 #include "eigen_utils.h"
 
 
 #include <math.h>
+#include <sys/resource.h>
 #include <functional>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <ios>
+#include <sstream>
+#include <memory>
 
 // #define SHOW_PROGRESS
 
@@ -34,6 +41,192 @@ make_search_engine(void)
   return Line_Search::GoldenSection(tolerance, searchInterval, initialGridSize, maxIterations);
 }
 
+MeanSearch
+make_mean_search (SolverOptions const& options)
+{
+  const double                   tolerance       (0.0001);          // as in make_search_engine
+  const std::pair<double,double> searchInterval  (std::make_pair(0.05,10.0));
+  const double                   initialGridSize (0.5);
+  const double                   halfWidth       ((options.warmStart || options.monotone || options.policyHints) ? 0.25 : 0.0);
+  return MeanSearch(make_search_engine(), tolerance, searchInterval, initialGridSize, halfWidth, options.newton);
+}
+
+
+LockstepSearch
+make_lockstep_search (void)
+{
+  const double                   tolerance       (0.0001);          // as in make_search_engine
+  const std::pair<double,double> searchInterval  (std::make_pair(0.05,10.0));
+  const double                   initialGridSize (0.5);
+  const int                      maxIterations   (200);
+  return LockstepSearch(tolerance, searchInterval, initialGridSize, maxIterations);
+}
+
+
+RejectionCurves*
+make_rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, SolverOptions const& options)
+{
+  if (options.tableStep <= 0.0)
+    return 0;
+  const std::pair<double,double> searchInterval  (std::make_pair(0.05,10.0));
+  RejectionCurves *curves (new RejectionCurves(rowWealth, colWealth, searchInterval, options.tableStep));
+  std::clog << messageTag << "Tabulated rejection curves at " << curves->grid_size() << " means in ["
+	    << searchInterval.first << "," << searchInterval.second << "]"
+	    << (options.refineTable ? ", refined by local search" : "") << std::endl;
+  return curves;
+}
+
+
+std::shared_ptr<const TransitionStencil>
+shared_stencil (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, int valueBytes, SolverOptions const& options)
+{
+  if (options.tables)
+    return options.tables->stencil(rowWealth, colWealth, valueBytes);
+  return std::shared_ptr<const TransitionStencil>(new TransitionStencil(rowWealth, colWealth, 0, valueBytes));
+}
+
+
+std::shared_ptr<const RejectionCurves>
+shared_rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, SolverOptions const& options)
+{
+  if (options.tableStep <= 0.0)
+    return std::shared_ptr<const RejectionCurves>();
+  if (options.tables)
+    return options.tables->rejection_curves(rowWealth, colWealth, options);
+  return std::shared_ptr<const RejectionCurves>(make_rejection_curves(rowWealth, colWealth, options));
+}
+
+
+RejectionBounds*
+make_rejection_bounds (std::vector<double> const& levels, SolverOptions const& options)
+{
+  if (!options.prune)
+    return 0;
+  const std::pair<double,double> searchInterval  (std::make_pair(0.05,10.0));
+  const int                      nPieces         (40);
+  return new RejectionBounds(levels, searchInterval, nPieces);
+}
+
+
+bool
+parse_precision (std::string const& s, SolverOptions::Precision *p)
+{
+  if      (s == "float")  *p = SolverOptions::floatValues;
+  else if (s == "mixed")  *p = SolverOptions::mixedValues;
+  else if (s == "double") *p = SolverOptions::doubleValues;
+  else return false;
+  return true;
+}
+
+
+const char*
+precision_name (SolverOptions::Precision p)
+{
+  switch (p)
+  {
+  case SolverOptions::floatValues:  return "float";
+  case SolverOptions::doubleValues: return "double";
+  default:                          return "mixed";
+  }
+}
+
+
+bool
+use_checkpoints (SolverOptions const& options, bool hasPolicies)
+{
+  if ((options.checkpointEvery < 1) && !options.resume)
+    return false;
+  if ((0.0 < options.stationaryTol) || options.reachable || hasPolicies)
+  { std::clog << messageTag << "Checkpoints count rounds from the end; not used with a stationary solve, reachable states or policy hints." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+
+BackgroundWriter*
+make_background_writer (SolverOptions const& options)
+{
+  if (options.ioQueue < 1)
+    return 0;
+  return new BackgroundWriter(options.ioQueue);
+}
+
+
+ReachableStates*
+make_reachable_states (DualWealthArray const& wealth, int nRounds, SolverOptions const& options)
+{
+  if (!options.reachable)
+    return 0;
+  if (0.0 < options.stationaryTol)
+  { std::clog << messageTag << "Stationary solve compares every state; ignoring reachable states." << std::endl;
+    return 0;
+  }
+  return new ReachableStates(wealth, nRounds, options.allHorizons);
+}
+
+
+StationaryMonitor*
+make_stationary_monitor (int nRounds, SolverOptions const& options)
+{
+  if (options.stationaryTol <= 0.0)
+    return 0;
+  return new StationaryMonitor(options.stationaryTol, options.accelerate, nRounds);
+}
+
+
+void
+extrapolate_horizons (StationaryMonitor const& monitor, std::vector<HorizonValues> &horizons, int nRounds)
+{
+  const int solved ((int) horizons.size());
+  if (solved == nRounds)
+  { std::clog << messageTag << "Not stationary after " << nRounds << " rounds; increments change by "
+	      << monitor.change() << ", extrapolation by " << monitor.remaining() << std::endl;
+    return;
+  }
+  StationaryMonitor::Values drift (monitor.drift());
+  std::clog << messageTag << "Stationary after " << solved << " rounds (increments change by " << monitor.change()
+	    << ", extrapolation by " << monitor.remaining() << "); drift per round "
+	    << drift.v[0] << " " << drift.v[1] << " " << drift.v[2] << "; extrapolated to " << nRounds << " rounds." << std::endl;
+  for (int h=solved+1; h<=nRounds; ++h)
+  { StationaryMonitor::Values v (monitor.extrapolate(h));
+    HorizonValues hv = { v.v[0], v.v[1], v.v[2] };
+    horizons.push_back(hv);
+  }
+}
+
+
+std::vector<double>
+bids_of (DualWealthArray const& wealth)
+{
+  std::vector<double> bids (wealth.number_wealth_positions());
+  for (int k=0; k<(int)bids.size(); ++k)
+    bids[k] = wealth.bid(k);
+  return bids;
+}
+
+
+void
+write_horizons (std::ostream& os, std::string const& config, std::vector<HorizonValues> const& horizons, bool all)
+{
+  const int nRounds ((int) horizons.size());
+  for (int h = all ? 1 : nRounds; h <= nRounds; ++h)
+  { HorizonValues const& v (horizons[h-1]);
+    os << std::setprecision(8)
+       << config << "   " << h << "   " << v.utility << " " << v.row << " " << v.col << std::endl;
+  }
+}
+
+
+double
+peak_resident_mb ()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+  return usage.ru_maxrss / 1024.0;                        // kilobytes on Linux
+}
+
 
 //  Find the risk associated with a Bayesian spike model; this is the code that generates the paths within feasible set
 
@@ -72,64 +265,276 @@ find_process_risk (int nRounds, double pZero, double mu, VectorUtility & utility
 //        * Version uses wealth sliced on y-axis, Lebesgue style
 //
 
+//  State of the vector recursion for one angle.  Values are kept for every row when writing
+//  details; otherwise only the rows being filled and read, alternating by the parity of the row.
+//  With bounded memory, details keep only the means (and rejection probabilities) of every row.
+//  Values are stored as Scalar (float or double); the interpolation is done in double.
+//  Util is the type of the utility, VectorUtility unless all the angles share a final type.
+
+namespace {
+
+  template <class Scalar, class Util>
+  struct VectorSweep
+  {
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> Values;
+
+    Util                     *utility;
+    MeanPolicy               *policy;                                 // hints from and for another solve, if any
+    MeanSearch                search;
+    const bool                details;                                // keep means for writing
+    const bool                allRows;                                //   ... and values
+    Values                    utilityMat, oracleMat, bidderMat;       // padded with a boundary column
+    Matrix                    meanMat, rejectProbMat;                 // for details only
+    std::vector<double>       searchMean;                             // optimum found by search before comparing to mu=0
+    std::vector<int>          searchRival;                            // grid point of the other mode, kept across rows
+    std::vector<double>       utilityIfReject, utilityIfBid;          // lockstep lanes
+    LockstepSearch            lockstep;
+    long                      nLockstep;                              // lanes searched in lockstep
+    std::vector<double>       lockMean, lockUtil, lockUtilAtZero;
+    std::unique_ptr<StationaryMonitor> monitor;
+    std::vector<HorizonValues> horizons;                              // by rounds solved
+    double                    meanAtZero;                             // in the last row solved
+    int                       lastRow;                                // rows above are not solved once stationary
+    bool                      done;
+
+    VectorSweep (Util *util, MeanPolicy *pol, int nRounds, int nColumns, bool writeDetails, SolverOptions const& options)
+      : utility(util), policy(pol), search(make_mean_search(options)),
+	details(writeDetails), allRows(writeDetails && !options.boundedMemory),
+	utilityMat(Values::Zero(allRows ? nRounds+1 : 2, nColumns+1)),   // +1 for initializing
+	oracleMat (Values::Zero(allRows ? nRounds+1 : 2, nColumns+1)),
+	bidderMat (Values::Zero(allRows ? nRounds+1 : 2, nColumns+1)),
+	meanMat      (Matrix::Zero(details ? nRounds : 0, nColumns)),
+	rejectProbMat(Matrix::Zero(details ? nRounds : 0, nColumns)),
+	searchMean(nColumns, 0.0), searchRival(nColumns, -1),
+	utilityIfReject(nColumns), utilityIfBid(nColumns),
+	lockstep(make_lockstep_search()), nLockstep(0), lockMean(nColumns), lockUtil(nColumns), lockUtilAtZero(nColumns),
+	monitor(make_stationary_monitor(nRounds, options)), horizons(), meanAtZero(0.0), lastRow(0), done(false) { }
+
+    int slot (int row) const { return allRows ? row : (row & 1); }   // row of the matrices holding this row
+  };
+
+  template <class Scalar, class Util>
+  std::vector<AngleSummary>
+  solve_vector_sweeps (int nRounds, std::vector<Util*> const& utilities, DualWealthArray const& wealth,
+		       bool writeDetails, SolverOptions const& options, std::vector<MeanPolicy> *policies);
+
+  // solves as utilities of type Util if all of them have it (false if not), so that the searches
+  // call the utility directly and can inline it
+  template <class Scalar, class Util>
+  bool
+  solve_if_type (std::vector<AngleSummary> *summaries, int nRounds, std::vector<VectorUtility*> const& utilities,
+		 DualWealthArray const& wealth, bool writeDetails, SolverOptions const& options, std::vector<MeanPolicy> *policies)
+  { std::vector<Util*> typed;
+    for (VectorUtility *u : utilities)
+    { Util *p (dynamic_cast<Util*>(u));
+      if (!p) return false;
+      typed.push_back(p);
+    }
+    *summaries = solve_vector_sweeps<Scalar>(nRounds, typed, wealth, writeDetails, options, policies);
+    return true;
+  }
+
+  template <class Scalar>
+  std::vector<AngleSummary>
+  solve_vector_types (int nRounds, std::vector<VectorUtility*> const& utilities, DualWealthArray const& wealth,
+		      bool writeDetails, SolverOptions const& options, std::vector<MeanPolicy> *policies)
+  {
+    std::vector<AngleSummary> summaries;
+    if (solve_if_type<Scalar, RejectVectorUtility>                                        (&summaries, nRounds, utilities, wealth, writeDetails, options, policies)
+	|| solve_if_type<Scalar, BasicRiskVectorUtility<LeastSquaresOracle, AngleCriterion>> (&summaries, nRounds, utilities, wealth, writeDetails, options, policies)
+	|| solve_if_type<Scalar, BasicRiskVectorUtility<RiskInflationOracle,AngleCriterion>> (&summaries, nRounds, utilities, wealth, writeDetails, options, policies)
+	|| solve_if_type<Scalar, BasicRiskVectorUtility<TestimatorOracle,   AngleCriterion>> (&summaries, nRounds, utilities, wealth, writeDetails, options, policies)
+	|| solve_if_type<Scalar, RiskVectorUtility>                                          (&summaries, nRounds, utilities, wealth, writeDetails, options, policies))
+      return summaries;
+    return solve_vector_sweeps<Scalar>(nRounds, utilities, wealth, writeDetails, options, policies);   // mixed types
+  }
+}
+
+
 void
-solve_bellman_vector_utility  (int nRounds, VectorUtility &utility, DualWealthArray const& wealth, bool writeDetails)
+solve_bellman_vector_utility  (int nRounds, VectorUtility &utility, DualWealthArray const& wealth, bool writeDetails,
+			       SolverOptions const& options)
+{
+  std::vector<AngleSummary> summary (solve_bellman_vector_utilities(nRounds, std::vector<VectorUtility*>(1, &utility), wealth,
+								    writeDetails, options));
+  write_horizons(std::cout, summary[0].config, summary[0].horizons, options.allHorizons);
+}
+
+
+//  Float and mixed precision both store floats; the vector recursion interpolates in double
+
+std::vector<AngleSummary>
+solve_bellman_vector_utilities  (int nRounds, std::vector<VectorUtility*> const& utilities, DualWealthArray const& wealth,
+				 bool writeDetails, SolverOptions const& options, std::vector<MeanPolicy> *policies)
 {
+  if (SolverOptions::mixedValues != options.precision)
+    std::clog << messageTag << "Solving with " << precision_name(options.precision) << " precision values." << std::endl;
+  if (SolverOptions::doubleValues == options.precision)
+    return solve_vector_types<double>(nRounds, utilities, wealth, writeDetails, options, policies);
+  return solve_vector_types<float>(nRounds, utilities, wealth, writeDetails, options, policies);
+}
+
+
+namespace {
+
+template <class Scalar, class Util>
+std::vector<AngleSummary>
+solve_vector_sweeps  (int nRounds, std::vector<Util*> const& utilities, DualWealthArray const& wealth,
+		      bool writeDetails, SolverOptions const& options, std::vector<MeanPolicy> *policies)
+{
+  typedef VectorSweep<Scalar,Util> Sweep;
   const int nColumns (wealth.number_wealth_positions());   
-  auto search = make_search_engine();
-  // pad arrays since need room to collect bid; initialize to zero; extra row for starting bottom up recursion
-  Matrix utilityMat= Matrix::Zero(nRounds+1, nColumns+1);  // +1 for initializing
-  Matrix oracleMat = Matrix::Zero(nRounds+1, nColumns+1);
-  Matrix bidderMat = Matrix::Zero(nRounds+1, nColumns+1);
-  // save for recreating mean stochastic process
-  Matrix meanMat       = Matrix::Zero(nRounds  , nColumns);
-  Matrix rejectProbMat = Matrix::Zero(nRounds  , nColumns);    // rejection prob
-  // store intermediates in rectangular array; fill from bottom up (don't get trapezoid with dual wealth)
+  if (1 < utilities.size())
+    std::clog << messageTag << "Solving " << utilities.size() << " angles in one sweep" << std::endl;
+  // the utility is flat in mu past small means, so a search started at the prior optimum settles on
+  // another point of the plateau than the full search, moving the results; warm start is not used
+  if (options.warmStart)
+    std::clog << messageTag << "Warm start does not apply to the vector solver; searching in full." << std::endl;
+  if (policies) policies->resize(utilities.size());
+  std::vector<std::unique_ptr<Sweep>> sweeps;
+  for (int i=0; i<(int)utilities.size(); ++i)
+    sweeps.emplace_back(new Sweep(utilities[i], policies ? &(*policies)[i] : 0, nRounds, nColumns, writeDetails, options));
+  // positions after rejecting or not (col, prob), and the bids of the columns with their z_alpha, shared by angles
+  std::vector<std::pair<int,double>> rejectPos (nColumns), bidPos (nColumns);
+  std::vector<double> beta (nColumns), zBeta (nColumns);
+  for (int k=0; k<nColumns; ++k)
+  { rejectPos[k] = wealth.reject_position(k);
+    bidPos[k] = wealth.bid_position(k);
+    beta[k] = (wealth.bid(k) < 1.0) ? wealth.bid(k) : 0.99;                 // as set_constants
+    zBeta[k] = z_alpha(beta[k]/2);
+  }
+  const std::vector<double> zeroMean (nColumns, 0.0);
+  // bounds to prune searches; alpha of the oracle is the only row (the same for every angle)
+  const std::unique_ptr<RejectionBounds> oracleBounds (make_rejection_bounds(std::vector<double>(1, utilities[0]->alpha()), options));
+  const std::unique_ptr<RejectionBounds> colBounds    (make_rejection_bounds(beta, options));
+  // columns reachable from the start in each row, else all of them (unsolved cells stay zero)
+  const std::unique_ptr<ReachableStates> reachable (make_reachable_states(wealth, nRounds, options));
+  std::vector<int> allColumns (nColumns);
+  for (int k=0; k<nColumns; ++k) allColumns[k] = k;
+  const int iZero (wealth.zero_index());
+  WorkerPool pool (options.nThreads);                                            // threads of every row
+  // fill from bottom up (the trapezoid is the reachable set)
   for (int row = nRounds-1; row > -1; --row)
-  { for (int k=0; k<nColumns; ++k)
-    { double bid (wealth.bid(k));
-      std::pair<int,double> rejectPos (wealth.reject_position(k));                 // where to go if reject (col, prob)
-      std::pair<int,double> bidPos    (wealth.bid_position(k));                    // did not reject
-      double utilityIfReject = utilityMat(row+1,rejectPos.first)*rejectPos.second + utilityMat(row+1,rejectPos.first+1)*(1-rejectPos.second);
-      double utilityIfBid    = utilityMat(row+1,   bidPos.first)*   bidPos.second + utilityMat(row+1,   bidPos.first+1)*(1-   bidPos.second);
-      double bidderIfReject  =  bidderMat(row+1,rejectPos.first)*rejectPos.second +  bidderMat(row+1,rejectPos.first+1)*(1-rejectPos.second);
-      double bidderIfBid     =  bidderMat(row+1,   bidPos.first)*   bidPos.second +  bidderMat(row+1,   bidPos.first+1)*(1-   bidPos.second);
-      double oracleIfReject  =  oracleMat(row+1,rejectPos.first)*rejectPos.second +  oracleMat(row+1,rejectPos.first+1)*(1-rejectPos.second);
-      double oracleIfBid     =  oracleMat(row+1,   bidPos.first)*   bidPos.second +  oracleMat(row+1,   bidPos.first+1)*(1-   bidPos.second);
-      utility.set_constants(bid, utilityIfReject, utilityIfBid);          
-      std::pair<double,double> maxPair (search.find_maximum(utility));            // mean and maximal utility
-      double utilAtMuEqualZero (utility(0.0));
-      if (maxPair.second < utilAtMuEqualZero)
-	maxPair = std::make_pair(0.0,utilAtMuEqualZero);
-      meanMat       (row,k) = maxPair.first;
-      rejectProbMat (row,k) = reject_prob(meanMat(row,k), (bid < 0.99) ? bid : 0.99); // insure prob less than 1
-      utilityMat    (row,k) = maxPair.second;
-      bidderMat     (row,k) = utility.bidder_utility(maxPair.first, bidderIfReject, bidderIfBid);
-      oracleMat     (row,k) = utility.oracle_utility(maxPair.first, oracleIfReject, oracleIfBid);
-    }
+  { std::vector<int> const& columns (reachable ? reachable->indices(row) : allColumns);
+    const int lo (columns.front()), hi (columns.back()+1);                         // lockstep lanes span [lo,hi)
+    std::vector<Sweep*> active;
+    for (std::unique_ptr<Sweep> const& pSweep : sweeps)
+      if (!pSweep->done) active.push_back(pSweep.get());
+    if (active.empty() || cancelled(options)) break;
+    parallel_for((int) active.size(), pool, [&] (int, int i)         // angles are independent within a row
+    { Sweep &s (*active[i]);
+      Util &utility (*s.utility);
+      const int next (s.slot(row+1)), cur (s.slot(row));
+      if (reachable)                                                               // unreached columns give no hints
+      { std::fill(s.searchMean.begin(), s.searchMean.end(), 0.0);
+	if (!s.allRows)                                                            //   and hold zero, as in all rows
+	{ s.utilityMat.row(cur).setZero(); s.oracleMat.row(cur).setZero(); s.bidderMat.row(cur).setZero(); }
+      }
+      for (int k=lo; k<hi; ++k)
+      { s.utilityIfReject[k] = s.utilityMat(next,rejectPos[k].first)*rejectPos[k].second + s.utilityMat(next,rejectPos[k].first+1)*(1-rejectPos[k].second);
+	s.utilityIfBid[k]    = s.utilityMat(next,   bidPos[k].first)*   bidPos[k].second + s.utilityMat(next,   bidPos[k].first+1)*(1-   bidPos[k].second);
+      }
+      if (options.lockstep)
+      { const VectorLanes lanes = { nColumns, &beta[0], &zBeta[0], &s.utilityIfReject[0], &s.utilityIfBid[0] };
+	const VectorLanes rowLanes (lanes.offset(lo, hi-lo));
+	s.nLockstep += hi-lo;
+	s.lockstep.find_maxima(utility, rowLanes, &s.lockMean[lo], &s.lockUtil[lo]);
+	utility.evaluate(rowLanes, &zeroMean[lo], &s.lockUtilAtZero[lo]);
+      }
+      for (int k : columns)
+      { double bid (wealth.bid(k));
+	std::pair<int,double> const& rPos (rejectPos[k]);
+	std::pair<int,double> const& bPos (bidPos[k]);
+	double bidderIfReject  =  s.bidderMat(next,rPos.first)*rPos.second +  s.bidderMat(next,rPos.first+1)*(1-rPos.second);
+	double bidderIfBid     =  s.bidderMat(next,bPos.first)*bPos.second +  s.bidderMat(next,bPos.first+1)*(1-bPos.second);
+	double oracleIfReject  =  s.oracleMat(next,rPos.first)*rPos.second +  s.oracleMat(next,rPos.first+1)*(1-rPos.second);
+	double oracleIfBid     =  s.oracleMat(next,bPos.first)*bPos.second +  s.oracleMat(next,bPos.first+1)*(1-bPos.second);
+	utility.set_constants(bid, s.utilityIfReject[k], s.utilityIfBid[k]);
+	std::pair<double,double> maxPair;                                         // mean and maximal utility
+	double utilAtMuEqualZero;
+	if (options.lockstep)
+	{ maxPair = std::make_pair(s.lockMean[k], s.lockUtil[k]);
+	  utilAtMuEqualZero = s.lockUtilAtZero[k];
+	}
+	else
+	{ utilAtMuEqualZero = utility(0.0);
+	  CurveWeights w;
+	  if (colBounds && utility.curve_weights(w) && (oracleBounds->upper_bound(w, 0, *colBounds, k) < utilAtMuEqualZero))
+	  { s.search.count_pruned();                                            // no mean in the interval beats mu=0
+	    maxPair = std::make_pair(0.0, utilAtMuEqualZero);
+	  }
+	  else
+	  { MeanHint hint;
+	    if (options.monotone && (0 < k))   hint.add(s.searchMean[k-1]);   // neighbour solved just before
+	    if (options.policyHints && hint.empty() && s.policy && s.policy->has(row))  // else the hints above are closer
+	      hint.add(s.policy->mean(row,k));
+	    maxPair = s.search.find_maximum(utility, hint.lo(), hint.hi(), &s.searchRival[k]);
+	  }
+	}
+	s.searchMean[k] = maxPair.first;
+	if (maxPair.second < utilAtMuEqualZero)
+	  maxPair = std::make_pair(0.0,utilAtMuEqualZero);
+	if (s.details)
+	{ s.meanMat       (row,k) = maxPair.first;
+	  s.rejectProbMat (row,k) = reject_prob(maxPair.first, (bid < 0.99) ? bid : 0.99); // insure prob less than 1
+	}
+	if (k == iZero) s.meanAtZero = maxPair.first;
+	s.utilityMat    (cur,k) = maxPair.second;
+	s.bidderMat     (cur,k) = utility.bidder_utility(maxPair.first, bidderIfReject, bidderIfBid);
+	s.oracleMat     (cur,k) = utility.oracle_utility(maxPair.first, oracleIfReject, oracleIfBid);
+      }
+      if (s.policy) s.policy->store(row, s.searchMean);
+      HorizonValues v = { s.utilityMat(cur,iZero), s.oracleMat(cur,iZero), s.bidderMat(cur,iZero) };
+      s.horizons.push_back(v);
+      s.lastRow = row;
+      s.done = s.monitor && s.monitor->update(s.utilityMat, s.oracleMat, s.bidderMat, cur, next, nColumns, iZero);
+    });
   }
-  // write solution (without boundary row) to file
-  if(writeDetails)
-  { std::ostringstream ss;
-    int angle (trunc(utility.angle()));
-    ss << "sim_details/dual_bellman.a" << angle << ".n" << nRounds << ".w" << round(100*wealth.initial_wealth())
-       << ".o" << round(100*wealth.omega()) << ".al" << round(100*utility.alpha()) << ".";
-    write_matrix_to_file(ss.str() + "utility",    utilityMat.topLeftCorner(nRounds+1,    utilityMat.cols()-1));  // omit boundary row, col
-    write_matrix_to_file(ss.str() + "oracle" ,     oracleMat.topLeftCorner(nRounds+1,     oracleMat.cols()-1));
-    write_matrix_to_file(ss.str() + "bidder" ,     bidderMat.topLeftCorner(nRounds+1,     bidderMat.cols()-1));
-    write_matrix_to_file(ss.str() + "mean"   ,       meanMat.topLeftCorner(nRounds  ,       meanMat.cols()));
-    write_matrix_to_file(ss.str() + "prob"   , rejectProbMat.topLeftCorner(nRounds  , rejectProbMat.cols()));
-    { std::ios_base::openmode mode = std::ios_base::trunc;
-      std::ofstream output (ss.str() + "wealth", mode);
-      wealth.write_to(output, true);  // true = as lines
-      output.close();
+  for (std::unique_ptr<Sweep> const& s : sweeps)
+    if (options.lockstep)
+      std::clog << messageTag << "Lockstep search for means: " << s->nLockstep << " searches with " << s->lockstep.evaluations()
+		<< " evaluations (" << (double) s->lockstep.evaluations() / s->nLockstep << " per search) in batches of "
+		<< LockstepSearch::batchSize << std::endl;
+    else
+      std::clog << messageTag << "Search for means: " << s->search.stats() << std::endl;
+  if (reachable)
+    std::clog << messageTag << "Reachable states: skipped " << 100*fraction_skipped(*reachable) << "% of "
+	      << nRounds*nColumns << " cells" << std::endl;
+  std::vector<AngleSummary> summaries;
+  for (std::unique_ptr<Sweep> const& pSweep : sweeps)
+  { Sweep &s (*pSweep);
+    // write solution (without boundary row, and rows not solved) to file
+    if(writeDetails)
+    { std::ostringstream ss;
+      int angle (trunc(s.utility->angle()));
+      ss << "sim_details/dual_bellman.a" << angle << ".n" << nRounds << ".w" << round(100*wealth.initial_wealth())
+	 << ".o" << round(100*wealth.omega()) << ".al" << round(100*s.utility->alpha()) << ".";
+      const int lastRow (s.lastRow), nSolved (nRounds - lastRow);
+      if (s.allRows)                                                    // else only the means were kept
+      { write_matrix_to_file(ss.str() + "utility",    s.utilityMat.block(lastRow, 0, nSolved+1,    s.utilityMat.cols()-1));  // omit boundary row, col
+	write_matrix_to_file(ss.str() + "oracle" ,     s.oracleMat.block(lastRow, 0, nSolved+1,     s.oracleMat.cols()-1));
+	write_matrix_to_file(ss.str() + "bidder" ,     s.bidderMat.block(lastRow, 0, nSolved+1,     s.bidderMat.cols()-1));
+      }
+      write_matrix_to_file(ss.str() + "mean"   ,       s.meanMat.block(lastRow, 0, nSolved  ,       s.meanMat.cols()));
+      write_matrix_to_file(ss.str() + "prob"   , s.rejectProbMat.block(lastRow, 0, nSolved  , s.rejectProbMat.cols()));
+      { std::ios_base::openmode mode = std::ios_base::trunc;
+	std::ofstream output (ss.str() + "wealth", mode);
+	wealth.write_to(output, true);  // true = as lines
+	output.close();
+      }
+    }
+    if (s.monitor)
+    { extrapolate_horizons(*s.monitor, s.horizons, nRounds);
+      std::clog << messageTag << "Mean at the start in the last round solved is " << s.meanAtZero << std::endl;
     }
+    std::ostringstream config;
+    config << std::setprecision(8) << s.utility->angle() << " " << wealth.omega();
+    AngleSummary summary = { config.str(), s.horizons };
+    summaries.push_back(summary);
   }
-  // locate starting position in array
-  int iZero = wealth.zero_index();
-  std::cout << std::setprecision(8)
-	    << utility.angle() << " " << wealth.omega() << "   " << nRounds   << "   " 
-	    << utilityMat(0,iZero) << " " << oracleMat(0,iZero) << " " << bidderMat(0,iZero) << std::endl;
+  std::clog << messageTag << "Peak resident set size " << peak_resident_mb() << " MB" << std::endl;
+  return summaries;
+}
 }
 
 
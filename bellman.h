@@ -1,8 +1,23 @@
+#ifndef _BELLMAN_H_
+#define _BELLMAN_H_
+
 #include <assert.h>
 
 #include "utility.h"
+#include "mean_search.h"
+#include "rejection_curves.h"
+#include "lockstep_search.h"
+#include "reachable.h"
+#include "stationary.h"
+#include "policy_store.h"
+#include "background_writer.h"
+#include "checkpoint.h"
 
 #include <iostream>      // debug
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
 
 /***********************************************************************************
 
@@ -11,12 +26,179 @@
 
 ***********************************************************************************/
 
+class TableSource;
+
+//  Options that control how the solvers do their work, not the problem being solved
+
+struct SolverOptions
+{
+  enum Precision { floatValues, mixedValues, doubleValues };   // storage and interpolation of values (value_planes.h)
+
+  int  nThreads;                      // threads sharing the cells of each round of the matrix solvers
+  bool warmStart;                     // start search for optimal mean near the optimum of the prior round
+  bool monotone;                      //   ... near the optima of neighbouring states solved in this round
+  bool policyHints;                   //   ... near the optima of a prior solve kept in a MeanPolicy, lacking other hints
+  double tableStep;                   // > 0 maximizes matrix utilities over tabulated curves with this spacing
+  bool refineTable;                   //   ... then refines the best mean in the table by a local search
+  bool newton;                        // local searches for the optimal mean use analytic derivatives
+  bool lockstep;                      // vector solver searches the columns of a row in lockstep batches
+  bool prune;                         // skip searches when bounds on the utility show mu=0 is optimal
+  bool allHorizons;                   // write the summary for every number of rounds up to the last, not just the last
+  bool reachable;                     // solve only the states reachable from the start in each round
+  double stationaryTol;               // > 0 stops once the per-round increments and the extrapolation settle this close
+  bool accelerate;                    //   ... extrapolating with the geometric tail of the increments
+  bool boundedMemory;                 // path details keep only the optimal means of each round, not the values
+  bool spillRounds;                   //   ... writing the means of each round of the matrix solver once it is done
+  bool quantizePolicy;                //   ... or holding them as 16-bit codes within the search tolerance
+  bool archivePath;                   // matrix path details go to one binary .bellpath file rather than text files per round
+  int  ioQueue;                       // rounds of path details waiting for the I/O thread; 0 writes them on the solver thread
+  int  checkpointEvery;               // > 0 saves the state of the space-conserving matrix solve every this many rounds, and at the end
+  bool resume;                        // start the space-conserving matrix solve from its latest checkpoint, if any
+  Precision precision;                // of the values of the space-conserving matrix and vector solvers
+  TableSource *tables;                // if not null, supplies the stencil and rejection curves of the space-conserving matrix solver
+  std::atomic<bool> const* cancel;    // if not null, the space-conserving and vector solvers stop after the round in which it is set
+
+  SolverOptions() : nThreads(1), warmStart(false), monotone(false), policyHints(false), tableStep(0.0), refineTable(false), newton(false),
+    lockstep(false), prune(false), allHorizons(false), reachable(false), stationaryTol(0.0), accelerate(false),
+    boundedMemory(false), spillRounds(false), quantizePolicy(false), archivePath(false), ioQueue(4),
+    checkpointEvery(0), resume(false), precision(mixedValues), tables(0), cancel(0) { }
+};
+
+//  Whether the caller has asked the solve to stop; the values of a cancelled solve are incomplete
+inline
+bool
+cancelled (SolverOptions const& options)
+{
+  return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+
+//  The stencil and the tables of rejection curves depend only on the wealth arrays (and on the size
+//  of the values or the spacing of the table), so solves on the same arrays can share them.  A
+//  TableSource in the options supplies them in place of building them for each solve (solve_server.h).
+
+class TransitionStencil;
+
+class TableSource
+{
+ public:
+  virtual ~TableSource() { }
+
+  virtual std::shared_ptr<const TransitionStencil> stencil          (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, int valueBytes) = 0;
+  virtual std::shared_ptr<const RejectionCurves>   rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth,
+								     SolverOptions const& options) = 0;
+};
+
+
+//  Values at the zero index of the wealth arrays once a round is solved.  Since the
+//  recursion does not depend on the round, the values after h rounds are the solution
+//  for a horizon of h rounds (on the wealth grid built for the longest horizon, which
+//  reaches lower wealth than that of a shorter run).
+
+struct HorizonValues
+{
+  double utility, row, col;
+};
+
+//  Result of a solve for one angle: its configuration and the values by horizon
+
+struct AngleSummary
+{
+  std::string                config;
+  std::vector<HorizonValues> horizons;
+};
+
+//  Writes the summary line (config, rounds, values) for the last horizon, or for each if all
+void
+write_horizons (std::ostream& os, std::string const& config, std::vector<HorizonValues> const& horizons, bool all);
+
+
+//  Largest resident memory of the process so far, in megabytes
+double
+peak_resident_mb ();
+
+
 //  Finds the expected risk for process with probability p_0 for 0 and 1-p_0 for the given mean
 
 std::pair<double,double>
   find_process_risk (int nRounds, double pZero, double mu, VectorUtility & utility, DualWealthArray const& bidderWealth);
 
 
+//  Search for the optimal mean used by the solvers; uses hints if the options say so
+
+MeanSearch
+make_mean_search (SolverOptions const& options);
+
+
+//  Golden section search over batches of columns for the vector solver
+
+LockstepSearch
+make_lockstep_search (void);
+
+
+//  Tables of rejection curves over the search interval for the matrix solvers; null unless the options ask for them
+
+RejectionCurves*
+make_rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, SolverOptions const& options);
+
+
+//  Stencil and rejection curves of a solve: from the table source of the options, else built for it
+
+std::shared_ptr<const TransitionStencil>
+shared_stencil (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, int valueBytes, SolverOptions const& options);
+
+std::shared_ptr<const RejectionCurves>
+shared_rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, SolverOptions const& options);
+
+
+//  Bounds on rejection curves for the given levels; null unless the options ask to prune
+
+RejectionBounds*
+make_rejection_bounds (std::vector<double> const& levels, SolverOptions const& options);
+
+std::vector<double>
+bids_of (DualWealthArray const& wealth);
+
+
+//  Positions reachable from the zero index in each round; null unless the options ask for them.
+//  With all horizons, the positions reached within t rounds so that every round covers the start.
+
+ReachableStates*
+make_reachable_states (DualWealthArray const& wealth, int nRounds, SolverOptions const& options);
+
+
+//  Precision from its name (float, mixed or double); false if not one of these
+
+bool
+parse_precision (std::string const& s, SolverOptions::Precision *p);
+
+const char*
+precision_name (SolverOptions::Precision p);
+
+
+//  Whether the space-conserving matrix solve saves or resumes checkpoints.  Not with a stationary
+//  solve, reachable states or the policies of a prior solve, which count rounds from the start.
+
+bool
+use_checkpoints (SolverOptions const& options, bool hasPolicies);
+
+
+//  Writes path details of the matrix solver on an I/O thread; null if the options give no queue
+
+BackgroundWriter*
+make_background_writer (SolverOptions const& options);
+
+
+//  Detects a stationary matrix recursion; null unless the options give a tolerance
+
+StationaryMonitor*
+make_stationary_monitor (int nRounds, SolverOptions const& options);
+
+//  Once stationary, fills the values of the horizons not solved by extrapolation
+void
+extrapolate_horizons (StationaryMonitor const& monitor, std::vector<HorizonValues> &horizons, int nRounds);
+
+
 //  These use a discrete wealth array to track the wealth of the bidder and (in constrained case) the oracle.
 //  Both use a convex mixture of states when new wealth is not element of the array
 //  Note: It's evil to pass in the reference,  but we don't care that the utility is modifiable; its there to be used.
@@ -24,7 +206,17 @@ std::pair<double,double>
 
 // oracle with no wealth constraint
 void
-solve_bellman_vector_utility  (int nRounds, VectorUtility &util,                               DualWealthArray const& wealth, bool writeDetails);
+solve_bellman_vector_utility  (int nRounds, VectorUtility &util,                               DualWealthArray const& wealth, bool writeDetails,
+			       SolverOptions const& options = SolverOptions());
+
+//  several angles (same alpha) in one backward sweep, sharing the wealth positions, bids and bounds;
+//  returns the summary of each utility in turn rather than writing it.  Angles are spread over
+//  threads within each row.  Keeps two rows per angle unless writing details.  Given policies (one
+//  per angle), the means they hold from a prior solve are hints where the options give none, and they
+//  are replaced by this solve.
+std::vector<AngleSummary>
+solve_bellman_vector_utilities (int nRounds, std::vector<VectorUtility*> const& utils,         DualWealthArray const& wealth, bool writeDetails,
+				SolverOptions const& options = SolverOptions(), std::vector<MeanPolicy> *policies = 0);
 
 
 // constrained oracle, two-player competition  (empty prefix means don't write)
@@ -33,11 +225,22 @@ solve_bellman_vector_utility  (int nRounds, VectorUtility &util,
 template<class MatrixUtil>
 void
 solve_bellman_matrix_utility  (int nRounds, MatrixUtil & util,
-			DualWealthArray const& oWealth,  DualWealthArray const& bidderWealth);
+			DualWealthArray const& oWealth,  DualWealthArray const& bidderWealth, SolverOptions const& options = SolverOptions());
+
+//  several angles in one sweep, sharing the stencil, tables of the rejection curves, bounds and
+//  reachable states; one value state per angle, and returns the summary of each utility in turn.
+//  Policies are used and replaced as in the vector version.
+template<class MatrixUtil>
+std::vector<AngleSummary>
+solve_bellman_matrix_utilities (int nRounds, std::vector<MatrixUtil> const& utils,
+			DualWealthArray const& oWealth,  DualWealthArray const& bidderWealth, SolverOptions const& options = SolverOptions(),
+			std::vector<MeanPolicy> *policies = 0);
 
 //  this version does save path information and writes out if asked (saves tensor)
 template<class MatrixUtil>
 void
 solve_bellman_matrix_utility  (int nRounds, MatrixUtil & util,
-			DualWealthArray const& oWealth,  DualWealthArray const& bidderWealth, std::string fileId, bool write);
+			DualWealthArray const& oWealth,  DualWealthArray const& bidderWealth, std::string fileId, bool write,
+			SolverOptions const& options = SolverOptions());
 
+#endif
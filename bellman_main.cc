@@ -2,9 +2,17 @@
 #include "line_search.Template.h"
 #include "wealth.Template.h"
 #include "utility.Template.h"
+#include "special_functions.h"
+#include "frontier.h"
+#include "solver_context.h"
+#include "solver_options.h"
+#include "solve_server.h"
 
 #include <math.h>
+#include <signal.h>
+#include <unistd.h>
 #include <tuple>
+#include <thread>
 #include <iostream>
 #include <getopt.h>
 #include "read_utils.h"     
@@ -48,26 +56,63 @@ round_parm(double x)
 // read command line
 void
 parse_arguments(int argc, char** argv,
-		bool &riskUtil, double &angle, Triple &oracle, Triple &bidder,
-		double &scale, int &nRounds,  bool &writeTable);
+		bool &riskUtil, std::vector<double> &angles, Triple &oracle, Triple &bidder,
+		double &scale, int &nRounds, int &extendTo, bool &writeTable, double &frontierTol,
+		std::string &critical, double &angleTol, SolverOptions &options);
 
+// comma separated list of angles, as in --angle 0,15,30
+std::vector<double>
+parse_angles(std::string const& list);
+
+// file name of the path details for an angle
+std::string
+config_name(int nRounds, double angle, Triple const& oracle, Triple const& bidder);
+
+// refines the angles until chords follow the frontier of (row, col) within the tolerance
+std::vector<AngleSummary>
+trace_frontier(std::vector<double> const& angles, double tolerance, bool riskUtil, Triple const& oracle, int nRounds,
+	       DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, SolverOptions const& options);
+
+// finds the angle in the bracket at which the target (utility, or row-col for balance) is zero;
+// writes the summaries of the solves and then the critical angle
+void
+find_critical_angle(std::vector<double> const& bracket, std::string const& target, double tolerance, bool riskUtil, Triple const& oracle,
+		    int nRounds, DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, SolverOptions const& options);
+
+
+
+// bellman serve [--socket path] [--workers n] [--cache n] [--accuracy a]: solves jobs read from stdin
+// (or the clients of the socket) until the end of input; see solve_server.h for the requests
+int
+serve(int argc, char** argv);
 
 
 // Main     Main     Main     Main     Main     Main     Main     Main     Main     Main     Main     Main     
 int  main(int argc, char** argv)
 {
+  if ((1 < argc) && (std::string("serve") == argv[1]))
+    return serve(argc-1, argv+1);
   // default arguments
   bool      riskUtil  = false;    // risk or rejection, default is rejection (which is fast)
-  double       angle  =     0;    // in degrees
+  std::vector<double> angles (1, 0.0);    // in degrees; several are solved in one sweep
   int        nRounds  =   100;
+  int        extendTo =     0;                           // if more than nRounds, continue a checkpointed solve of nRounds to this many
   double     scale    = 1.0;                           // multiplier of universal code in unconstrained  (no longer used)
   bool     writeTable = false;                         // if false, only return final value
+  double  frontierTol = 0.0;                           // if positive, refine angles to trace the frontier
+  std::string critical;                                // if utility or balance, find the angle where it is zero
+  double     angleTol = 1.0e-4;                        //   to this many degrees
   Triple    oracle    = std::make_tuple(-1,-1,-1);   //   (W0, alpha, oracle omega) omega=1 implies unconstrained
   Triple    bidder    = std::make_tuple(-1,-1,-1);   //   (W0, beta, bidder omega)  negative values on exit parse were not set
+  SolverOptions options;
 
-  parse_arguments(argc, argv, riskUtil, angle, oracle, bidder, scale, nRounds, writeTable);
+  parse_arguments(argc, argv, riskUtil, angles, oracle, bidder, scale, nRounds, extendTo, writeTable, frontierTol, critical, angleTol, options);
 
-  std::clog << "MAIN: Running " << nRounds << " rounds at angle " << angle << " with writeTable=" << writeTable << std::endl;
+  std::clog << "MAIN: Running " << nRounds << " rounds at " << angles.size() << " angle(s) from " << angles.front() << " with writeTable=" << writeTable
+	    << " using " << options.nThreads << " threads" << std::endl;
+  if (Special::exact != Special::accuracy())
+    std::clog << "MAIN: Normal cdf, density and quantile with accuracy " << Special::name(Special::accuracy())
+	      << " using " << Special::name(Special::isa()) << std::endl;
   /*
      Note that alpha (aka, the oracle probability for a Bayes oracle)
      'lives' in the utility function object, and W0 and omega are
@@ -77,40 +122,48 @@ int  main(int argc, char** argv)
   
   std::clog << "MAIN: Building bidder wealth array for "
 	    << nRounds << " rounds with " << bidder << ", and scale=" << scale << std::endl;
-  DualWealthArray *pBidderWealth = make_wealth_array(bidder, scale, nRounds);
+  std::unique_ptr<DualWealthArray> pBidderWealth (make_wealth_array(bidder, scale, nRounds));
   // pBidderWealth->write_to(std::clog, true); std::clog << std::endl; // as lines
 
+  std::unique_ptr<DualWealthArray> pOracleWealth;
   if(omega(oracle) == 1)  // unconstrained competitor
-  { std::clog << "MAIN: Oracle(W0,p,w)=" << oracle << " with bidder " << bidder << " and wealth function " << pBidderWealth->name() << std::endl;
-    if (riskUtil)
-    { RiskVectorUtility utility(angle, prob(oracle));
-      solve_bellman_vector_utility (nRounds, utility, *pBidderWealth, writeTable);
-    }
-    else
-    { RejectVectorUtility utility(angle, prob(oracle));
-      solve_bellman_vector_utility (nRounds, utility, *pBidderWealth, writeTable);
-    }
-  }
+    std::clog << "MAIN: Oracle(W0,p,w)=" << oracle << " with bidder " << bidder << " and wealth function " << pBidderWealth->name() << std::endl;
   else                    // constrained competitor needs to track state as well
   { std::clog << "MAIN: Column player (bidder) " << bidder << " with wealth array ... " << *pBidderWealth <<  std::endl;
-    DualWealthArray *pOracleWealth = make_wealth_array(oracle, scale, nRounds);
+    pOracleWealth.reset(make_wealth_array(oracle, scale, nRounds));
     std::clog << "MAIN: Row player (oracle)    " << oracle << " with wealth array ... " << *pOracleWealth << std::endl;
     std::clog << "MAIN: Players are : " << pOracleWealth->name() << " and " << pBidderWealth->name() << std::endl;
-    std::ostringstream ss;
-    ss << "n_" << nRounds << "_angle_" << angle << "_oracle_" << prob(oracle) << "_" << omega(oracle) << "_bidder_" << prob(bidder) << "_" << omega(bidder);
-    AngleCriterion ac(angle);
-    if (riskUtil)
-    { RiskMatrixUtility<AngleCriterion> utility(ac);
-      if (writeTable)
-	solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, ss.str(), writeTable); //tensor version
+  }
+  if (nRounds < extendTo)                                               // wealth arrays stay those of the solve extended
+  { std::clog << "MAIN: Extending the checkpointed solve of " << nRounds << " rounds to " << extendTo << " rounds" << std::endl;
+    nRounds = extendTo;
+    options.resume = true;
+  }
+  if (pOracleWealth && writeTable)                                      // tensor version, one angle at a time
+  { for (double angle : angles)
+      if (riskUtil)
+      { RiskMatrixUtility<AngleCriterion> utility((AngleCriterion(angle)));
+	solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, config_name(nRounds, angle, oracle, bidder), writeTable, options);
+      }
       else
-	solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth);	
-    }
-    else
-    { RejectMatrixUtility<AngleCriterion> utility(ac);
-      solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, ss.str(), writeTable);
-    }
+      { RejectMatrixUtility<AngleCriterion> utility((AngleCriterion(angle)));
+	solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, config_name(nRounds, angle, oracle, bidder), writeTable, options);
+      }
+    return 0;
+  }
+  if (!critical.empty())
+  { find_critical_angle(angles, critical, angleTol, riskUtil, oracle, nRounds, pOracleWealth.get(), *pBidderWealth, options);
+    return 0;
   }
+  std::vector<AngleSummary> summaries;
+  if (0 < frontierTol)
+  { if (writeTable) std::clog << "MAIN: Not writing details while tracing the frontier." << std::endl;
+    summaries = trace_frontier(angles, frontierTol, riskUtil, oracle, nRounds, pOracleWealth.get(), *pBidderWealth, options);
+  }
+  else
+    summaries = solve_angles(angles, riskUtil, prob(oracle), nRounds, pOracleWealth.get(), *pBidderWealth, writeTable, options);
+  for (AngleSummary const& summary : summaries)
+    write_horizons(std::cout, summary.config, summary.horizons, options.allHorizons);
   return 0;
 }
 
@@ -118,10 +171,11 @@ int  main(int argc, char** argv)
 
 void
 parse_arguments(int argc, char** argv,
-		bool &riskUtil, double &angle, Triple &oracleIPO, Triple &bidderIPO,
-		double &scale, int &nRounds,  bool &writeTable)
+		bool &riskUtil, std::vector<double> &angles, Triple &oracleIPO, Triple &bidderIPO,
+		double &scale, int &nRounds, int &extendTo, bool &writeTable, double &frontierTol,
+		std::string &critical, double &angleTol, SolverOptions &options)
 {
-  static struct option long_options[] = {
+  const std::vector<option> program_options = {
     {"risk",               no_argument, 0, 'R'},
     {"reject",             no_argument, 0, 'r'},
     {"angle",        required_argument, 0, 'a'},
@@ -134,12 +188,17 @@ parse_arguments(int argc, char** argv,
     {"scale",        required_argument, 0, 's'},
     {"rounds",       required_argument, 0, 'n'},
     {"write",              no_argument, 0, 'w'},
-    {0, 0, 0, 0}                             // terminator 
+    {"frontier",     required_argument, 0, 'F'},
+    {"critical",     required_argument, 0, 'C'},
+    {"angle-tol",    required_argument, 0, 'G'},
+    {"extend-to",    required_argument, 0, 'E'},
   };
+  const std::vector<option> long_options (with_solver_options(program_options, allSolverOptions));
+  const std::string letters (with_solver_letters("Rra:i:o:O:I:b:B:s:n:wF:C:G:E:", allSolverOptions));
   int key;
   int option_index = 0;
   bool rejectUtil = true;
-  while (-1 !=(key = getopt_long (argc, argv, "Rra:i:o:O:I:b:B:s:n:w", long_options, &option_index))) // colon means has argument
+  while (-1 !=(key = getopt_long (argc, argv, letters.c_str(), &long_options[0], &option_index))) // colon means has argument
   {
     // std::cout << "Option key " << char(key) << " for option " << long_options[option_index].name << ", option_index=" << option_index << std::endl;
     switch (key)
@@ -156,7 +215,7 @@ parse_arguments(int argc, char** argv,
       }
     case 'a' : 
       {
-	angle = read_utils::lexical_cast<double>(optarg);
+	angles = parse_angles(optarg);
 	break;
       }
     case 'n' :
@@ -204,9 +263,34 @@ parse_arguments(int argc, char** argv,
 	writeTable=true ;
 	break;
       }
+    case 'F' :
+      {
+	frontierTol = read_utils::lexical_cast<double>(optarg);
+	break;
+      }
+    case 'C' :
+      {
+	critical = optarg;
+	if ((critical != "utility") && (critical != "balance"))
+	{ std::cout << "PARSE: Critical target " << critical << " is not utility or balance; ignored.\n";
+	  critical.clear();
+	}
+	break;
+      }
+    case 'G' :
+      {
+	angleTol = read_utils::lexical_cast<double>(optarg);
+	break;
+      }
+    case 'E' :
+      {
+	extendTo = read_utils::lexical_cast<int>(optarg);
+	break;
+      }
     default:
       {
-	std::cout << "PARSE: Option not recognized; returning.\n";
+	if (!parse_solver_option(key, optarg, options))
+	  std::cout << "PARSE: Option not recognized; returning.\n";
       }
     } // switch
   } // while
@@ -217,25 +301,171 @@ parse_arguments(int argc, char** argv,
 }
 
 
+int
+serve(int argc, char** argv)
+{
+  static struct option long_options[] = {
+    {"socket",       required_argument, 0, 'u'},
+    {"workers",      required_argument, 0, 'j'},
+    {"cache",        required_argument, 0, 'c'},
+    {"accuracy",     required_argument, 0, 'A'},
+    {0, 0, 0, 0}                             // terminator 
+  };
+  std::string socketPath;                                        // empty serves stdin and stdout
+  int nWorkers  (std::max(1, (int) std::thread::hardware_concurrency()));
+  int cacheSize (8);
+  int key;
+  int option_index = 0;
+  while (-1 !=(key = getopt_long (argc, argv, "u:j:c:A:", long_options, &option_index)))
+  { switch (key)                                                 // stdout carries the responses, so messages go to clog
+    {
+    case 'u' : { socketPath = optarg; break; }
+    case 'j' : { nWorkers = read_utils::lexical_cast<int>(optarg); break; }
+    case 'c' : { cacheSize = read_utils::lexical_cast<int>(optarg); break; }
+    case 'A' :
+      {
+	Special::Accuracy accuracy;
+	if (Special::parse_accuracy(optarg, &accuracy))
+	  Special::set_accuracy(accuracy);
+	else
+	  std::clog << "PARSE: Accuracy " << optarg << " is not exact, 1e-10 or 1e-7; using " << Special::name(Special::accuracy()) << ".\n";
+	break;
+      }
+    default: { std::clog << "PARSE: Option not recognized by serve; ignored.\n"; }
+    }
+  }
+  signal(SIGPIPE, SIG_IGN);                                      // a client that goes away fails the write instead
+  SolveServer server (nWorkers, cacheSize);
+  if (socketPath.empty())
+    server.serve_stream(STDIN_FILENO, STDOUT_FILENO);
+  else if (!server.serve_socket(socketPath))
+    return 1;
+  server.finish();
+  return 0;
+}
+
+
+std::vector<double>
+parse_angles(std::string const& list)
+{
+  std::vector<double> angles;
+  std::istringstream input(list);
+  std::string item;
+  while (std::getline(input, item, ','))
+    if (!item.empty())
+      angles.push_back(read_utils::lexical_cast<double>(item.c_str()));
+  if (angles.empty())
+  { std::cout << "PARSE: No angle in " << list << "; using 0.\n";
+    angles.push_back(0.0);
+  }
+  return angles;
+}
+
+
+std::string
+config_name(int nRounds, double angle, Triple const& oracle, Triple const& bidder)
+{
+  std::ostringstream ss;
+  ss << "n_" << nRounds << "_angle_" << angle << "_oracle_" << prob(oracle) << "_" << omega(oracle) << "_bidder_" << prob(bidder) << "_" << omega(bidder);
+  return ss.str();
+}
+
+
+std::vector<AngleSummary>
+trace_frontier(std::vector<double> const& angles, double tolerance, bool riskUtil, Triple const& oracle, int nRounds,
+	       DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, SolverOptions const& options)
+{
+  const double minStep   (0.001);    // degrees; finest steps used by hand in the figures
+  const int    maxAngles (500);
+  FrontierTracer tracer (tolerance, minStep, maxAngles);
+  std::vector<std::pair<double,AngleSummary>> solved;
+  std::vector<double> pass (angles);
+  std::sort(pass.begin(), pass.end());
+  pass.erase(std::unique(pass.begin(), pass.end()), pass.end());
+  for (int k=0; !pass.empty(); ++k)
+  { std::clog << "MAIN: Frontier pass " << k << " solves " << pass.size() << " angles from " << pass.front() << " to " << pass.back() << std::endl;
+    std::vector<AngleSummary> summaries (solve_angles(pass, riskUtil, prob(oracle), nRounds, pOracleWealth, bidderWealth, false, options));
+    std::vector<FrontierTracer::Point> points;
+    for (int i=0; i<(int)pass.size(); ++i)
+    { HorizonValues const& v (summaries[i].horizons.back());
+      FrontierTracer::Point p = { pass[i], v.row, v.col };
+      points.push_back(p);
+      solved.push_back(std::make_pair(pass[i], summaries[i]));
+    }
+    tracer.add(points);
+    pass = tracer.next_angles();
+  }
+  std::clog << "MAIN: Frontier traced with " << solved.size() << " angles to tolerance " << tolerance << std::endl;
+  std::stable_sort(solved.begin(), solved.end(),
+		   [] (std::pair<double,AngleSummary> const& a, std::pair<double,AngleSummary> const& b) { return a.first < b.first; });
+  std::vector<AngleSummary> result;
+  for (auto const& s : solved)
+    result.push_back(s.second);
+  return result;
+}
+
+
+void
+find_critical_angle(std::vector<double> const& bracket, std::string const& target, double tolerance, bool riskUtil, Triple const& oracle,
+		    int nRounds, DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, SolverOptions const& options)
+{
+  const int maxSolves (40);
+  if (bracket.size() != 2)
+  { std::clog << "MAIN: Critical angle needs a bracket of two angles, as in --angle 93,97." << std::endl;
+    return;
+  }
+  std::vector<MeanPolicy> policies;                // means of the last solve hint the next
+  SolverOptions hinted (options);
+  hinted.policyHints = true;
+  std::vector<std::pair<double,AngleSummary>> solved;
+  auto f = [&] (double angle) -> double
+    { std::vector<AngleSummary> summaries (solve_angles(std::vector<double>(1,angle), riskUtil, prob(oracle), nRounds,
+							pOracleWealth, bidderWealth, false, hinted, &policies));
+      solved.push_back(std::make_pair(angle, summaries[0]));
+      HorizonValues const& v (summaries[0].horizons.back());
+      const double value ((target == "utility") ? v.utility : v.row - v.col);
+      std::clog << "MAIN: Solve " << solved.size() << " at angle " << std::setprecision(10) << angle << " gives " << target << " " << value << std::endl;
+      return value;
+    };
+  double a (bracket[0]), b (bracket[1]);
+  double fa (f(a)), fb (f(b));
+  bool found (false);
+  if (fa*fb > 0)
+    std::clog << "MAIN: The " << target << " has the same sign at both ends of [" << a << "," << b << "]; no critical angle." << std::endl;
+  else                                             // Illinois variant of regula falsi; b is the latest estimate
+  { found = true;
+    while ((tolerance < fabs(b-a)) && (fb != 0.0) && ((int) solved.size() < maxSolves))
+    { const double c (b - fb*(b-a)/(fb-fa));
+      const double fc (f(c));
+      if (fc*fb < 0)                               // root between b and c
+      { a = b; fa = fb; }
+      else                                         // same end kept twice, halve its value
+	fa /= 2;
+      b = c; fb = fc;
+    }
+  }
+  std::stable_sort(solved.begin(), solved.end(),
+		   [] (std::pair<double,AngleSummary> const& x, std::pair<double,AngleSummary> const& y) { return x.first < y.first; });
+  for (auto const& s : solved)
+    write_horizons(std::cout, s.second.config, s.second.horizons, options.allHorizons);
+  if (found)
+  { std::clog << "MAIN: Critical angle for " << target << " is " << b << " after " << solved.size() << " solves" << std::endl;
+    std::cout << std::setprecision(10) << "critical " << target << " " << b << " " << std::min(a,b) << " " << std::max(a,b)
+	      << " " << solved.size() << std::endl;
+  }
+}
+
+
 DualWealthArray*
 make_wealth_array(Triple const& parms, double scale, int nRounds)
 {
-  const double maxWealthArray (10.0);
-  
   if (1 == omega(parms))             // unconstrained, fixed wealth testimator
-  { double w0 = W0(parms);
-    std::clog << "MAIN: Fixed bidder with constant wealth=" << w0 << std::endl;
-    return new DualWealthArray(w0);
-  }
+    std::clog << "MAIN: Fixed bidder with constant wealth=" << W0(parms) << std::endl;
   else if(0 == prob(parms))          // universal
-  { std::clog << "MAIN: Making universal array with scale=" << scale << " and W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
-    UniversalRule bidder;
-    return new DualWealthArray(bidder.identifier(), maxWealthArray, W0(parms), omega(parms), bidder, nRounds);
-  }
+    std::clog << "MAIN: Making universal array with scale=" << scale << " and W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
   else                               // geometric
-  { std::clog << "MAIN: Making geometric wealth array with p=" << prob(parms) << ", scale=" << scale
+    std::clog << "MAIN: Making geometric wealth array with p=" << prob(parms) << ", scale=" << scale
 	      << " and W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
-    GeometricRule geoBidder(prob(parms));
-    return new DualWealthArray(geoBidder.identifier(), maxWealthArray, W0(parms), omega(parms), geoBidder, nRounds);
-  }
+  const PlayerSpec player = { W0(parms), prob(parms), omega(parms) };
+  return make_player_wealth(player, nRounds);
 }
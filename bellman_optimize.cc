@@ -2,6 +2,9 @@
 #include "line_search.Template.h"
 #include "wealth.Template.h"
 #include "utility.Template.h"
+#include "special_functions.h"
+#include "solver_context.h"
+#include "solver_options.h"
 
 #include <math.h>
 #include <tuple>
@@ -48,7 +51,7 @@ round_parm(double x)
 void
 parse_arguments(int argc, char** argv,
 		bool &riskUtil, double &angle, Triple &oracle, Triple &bidder,
-		 int &nRounds,  bool &writeTable);
+		 int &nRounds,  bool &writeTable, SolverOptions &options);
 
 
 
@@ -65,21 +68,25 @@ int  main(int argc, char** argv)
   bool     writeTable = false;                             // if false, only return final value
   Triple    oracle    = std::make_tuple(0.25, 0, 0.25);    //   (W0, univ, omega)              omega=1 implies unconstrained
   Triple    baseBidder= std::make_tuple(0.25,-1, 0.25);    //   (W0, beta, bidder omega)       negative values on exit parse were not set
+  SolverOptions options;
 
-  parse_arguments(argc, argv, riskUtil, angle, oracle, baseBidder,  nRounds, writeTable);
+  parse_arguments(argc, argv, riskUtil, angle, oracle, baseBidder,  nRounds, writeTable, options);
 
   std::clog << "MAIN: Oracle  " << oracle << std::endl;
-  DualWealthArray *pOracleWealth = make_wealth_array(oracle,  nRounds);
+  if (Special::exact != Special::accuracy())
+    std::clog << "MAIN: Normal cdf, density and quantile with accuracy " << Special::name(Special::accuracy())
+	      << " using " << Special::name(Special::isa()) << std::endl;
+  std::unique_ptr<DualWealthArray> pOracleWealth (make_wealth_array(oracle,  nRounds));
 
   std::vector<double> psiVec = {.0001, 0.001, 0.01, 0.05, 0.10, 0.20, 0.30, 0.50};
 
   for(auto psi : psiVec)
   { Triple bidder = std::make_tuple(W0(baseBidder), psi, omega(baseBidder));
     std::cout << "MAIN: Bidder " << bidder << std::endl;
-    DualWealthArray *pBidderWealth = make_wealth_array(bidder,  nRounds);
+    std::unique_ptr<DualWealthArray> pBidderWealth (make_wealth_array(bidder,  nRounds));
     RiskInflationCriterion ri(RiB1);
     RiskMatrixUtility<RiskInflationCriterion> utility(ri);
-    solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, " ", writeTable);
+    solve_bellman_matrix_utility (nRounds, utility, *pOracleWealth, *pBidderWealth, " ", writeTable, options);
   }
   return 0;
 }
@@ -89,9 +96,9 @@ int  main(int argc, char** argv)
 void
 parse_arguments(int argc, char** argv,
 		bool &riskUtil, double &angle, Triple &oracleIPO, Triple &bidderIPO,
-		 int &nRounds,  bool &writeTable)
+		 int &nRounds,  bool &writeTable, SolverOptions &options)
 {
-  static struct option long_options[] = {
+  const std::vector<option> program_options = {
     {"risk",               no_argument, 0, 'R'},
     {"reject",             no_argument, 0, 'r'},
     {"angle",        required_argument, 0, 'a'},
@@ -103,12 +110,13 @@ parse_arguments(int argc, char** argv,
     {"bidder_omega", required_argument, 0, 'B'},
     {"rounds",       required_argument, 0, 'n'},
     {"write",              no_argument, 0, 'w'},
-    {0, 0, 0, 0}                             // terminator 
   };
+  const std::vector<option> long_options (with_solver_options(program_options, tensorSolverOptions));
+  const std::string letters (with_solver_letters("Rra:i:o:O:I:b:B:n:w", tensorSolverOptions));
   int key;
   int option_index = 0;
   bool rejectUtil = true;
-  while (-1 !=(key = getopt_long (argc, argv, "Rra:i:o:O:I:b:B:n:w", long_options, &option_index))) // colon means has argument
+  while (-1 !=(key = getopt_long (argc, argv, letters.c_str(), &long_options[0], &option_index))) // colon means has argument
   {
     // std::cout << "Option key " << char(key) << " for option " << long_options[option_index].name << ", option_index=" << option_index << std::endl;
     switch (key)
@@ -170,7 +178,8 @@ parse_arguments(int argc, char** argv,
       }
     default:
       {
-	std::cout << "PARSE: Option not recognized; returning.\n";
+	if (!parse_solver_option(key, optarg, options))
+	  std::cout << "PARSE: Option not recognized; returning.\n";
       }
     } // switch
   } // while
@@ -187,19 +196,12 @@ make_wealth_array(Triple const& parms,  int nRounds)
   const double maxWealth (5.0);
   
   if (1 == omega(parms))             // unconstrained, fixed wealth testimator
-  { double w0 = W0(parms);
-    std::clog << "MAIN: Fixed bidder with constant wealth=" << w0 << std::endl;
-    return new DualWealthArray(w0);
-  }
+    std::clog << "MAIN: Fixed bidder with constant wealth=" << W0(parms) << std::endl;
   else if(0 == prob(parms))          // universal
-  { std::clog << "MAIN: Making universal array with " << " W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
-    UniversalRule bidder;
-    return new DualWealthArray(bidder.identifier(), maxWealth, W0(parms), omega(parms), bidder, nRounds);
-  }
+    std::clog << "MAIN: Making universal array with " << " W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
   else                               // geometric
-  { std::clog << "MAIN: Making geometric wealth array with p=" << prob(parms) 
+    std::clog << "MAIN: Making geometric wealth array with p=" << prob(parms) 
 	      << " and W0=" << W0(parms) << " omega=" << omega(parms) << std::endl;
-    GeometricRule geoBidder(prob(parms));
-    return new DualWealthArray(geoBidder.identifier(), maxWealth, W0(parms), omega(parms), geoBidder, nRounds);
-  }
+  const PlayerSpec player = { W0(parms), prob(parms), omega(parms) };
+  return make_player_wealth(player, nRounds, maxWealth);
 }
@@ -0,0 +1,45 @@
+#include "path_archive.h"
+
+#include "read_utils.h"
+
+#include <iostream>
+
+/*
+  Converts a path archive (.bellpath) written by bellman --write --archive into the text
+  files written without --archive, or prints the values held for one cell of a round.
+
+    bellpath_text sim_details/<config>.bellpath [dir]          text files into dir (default sim_details/)
+    bellpath_text sim_details/<config>.bellpath round r c      values at (r,c) after round (from the start)
+*/
+
+int
+main(int argc, char** argv)
+{
+  if ((argc != 2) && (argc != 3) && (argc != 5))
+  { std::cerr << "Usage: bellpath_text file.bellpath [dir] | file.bellpath round row col" << std::endl;
+    return 1;
+  }
+  PathArchive archive (argv[1]);
+  if (!archive.is_open())
+    return 1;
+  std::clog << "UTIL: Path archive of " << archive.config() << " holds " << archive.number_of_rounds() << " rounds of "
+	    << archive.rows() << " x " << archive.cols() << " cells with " << archive.number_of_planes() << " planes" << std::endl;
+  if (argc == 5)
+  { const int round (read_utils::lexical_cast<int>(argv[2]));
+    const int r     (read_utils::lexical_cast<int>(argv[3]));
+    const int c     (read_utils::lexical_cast<int>(argv[4]));
+    if ((round < 0) || (archive.number_of_rounds() <= round) || !archive.has_round(round) ||
+	(r < 0) || (archive.rows() <= r) || (c < 0) || (archive.cols() <= c))
+    { std::cerr << "UTIL: Round " << round << " cell (" << r << "," << c << ") is not held in the archive" << std::endl;
+      return 1;
+    }
+    const char* names[ValuePlanes::nPlanes] = { "utility", "row", "col", "mean" };
+    for (int p=0; p<ValuePlanes::nPlanes; ++p)
+      if (archive.has_plane((ValuePlanes::Plane) p))
+	std::cout << names[p] << " " << archive.value(round, r, c, (ValuePlanes::Plane) p) << std::endl;
+    return 0;
+  }
+  const std::string dir ((argc == 3) ? std::string(argv[2]) + "/" : std::string("sim_details/"));
+  archive.write_text(dir);
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "checkpoint.h"
+
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+  const char     magic[8] = { 'B','E','L','L','C','K','P','T' };
+  const uint32_t version  = 2;                             // 2: planes held as doubles
+
+  const std::string directory ("checkpoints/");
+
+  //  FNV-1a hash of bytes, continuing from h
+  uint64_t
+  fnv (void const* data, size_t n, uint64_t h = 14695981039346656037ULL)
+  { unsigned char const* p (static_cast<unsigned char const*>(data));
+    for (size_t i=0; i<n; ++i)
+    { h ^= p[i];
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  uint64_t
+  fingerprint (DualWealthArray const& wealth)
+  { uint64_t h (fnv(0, 0));
+    const int n (wealth.number_wealth_positions());
+    for (int k=0; k<n; ++k)
+    { const double d[4] = { wealth.wealth(k), wealth.bid(k), wealth.reject_prob(k), wealth.bid_jump_share(k) };
+      const int32_t  i[2] = { wealth.reject_index(k), wealth.bid_jumps_to(k) };
+      h = fnv(d, sizeof(d), h);
+      h = fnv(i, sizeof(i), h);
+    }
+    return h;
+  }
+
+  std::string
+  hex (uint64_t h)
+  { std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return ss.str();
+  }
+
+  template <class T>
+  bool
+  put (FILE *f, T const* x, size_t n)
+  { return (0 == n) || (fwrite(x, sizeof(T), n, f) == n); }
+
+  template <class T>
+  bool
+  get (FILE *f, T *x, size_t n)
+  { return (0 == n) || (fread(x, sizeof(T), n, f) == n); }
+}
+
+
+std::string
+checkpoint_key (std::string const& utility, DualWealthArray const& rowWealth, DualWealthArray const& colWealth)
+{
+  return utility + " row " + rowWealth.name() + " " + hex(fingerprint(rowWealth)) + " col " + colWealth.name() + " " + hex(fingerprint(colWealth));
+}
+
+
+std::string
+checkpoint_file (std::string const& key)
+{
+  return directory + hex(fnv(key.data(), key.size())) + ".ckpt";
+}
+
+
+//     MatrixCheckpoint     MatrixCheckpoint     MatrixCheckpoint     MatrixCheckpoint     MatrixCheckpoint
+
+bool
+MatrixCheckpoint::write (std::string fileName) const
+{
+  mkdir(directory.c_str(), 0755);                                         // fails harmlessly if there
+  const std::string temp (fileName + ".tmp");
+  FILE *f (fopen(temp.c_str(), "wb"));
+  if (!f)
+  { std::clog << "BELL: Could not open checkpoint " << temp << std::endl;
+    return false;
+  }
+  const uint32_t keyLength ((uint32_t) key.size());
+  const int32_t  shape[3] = { steps, planes.rows(), planes.cols() };
+  const double   interval[2] = { meanInterval.first, meanInterval.second };
+  const bool ok (put(f, magic, sizeof(magic)) && put(f, &version, 1) && put(f, &keyLength, 1) && put(f, key.data(), key.size())
+		 && put(f, shape, 3) && put(f, interval, 2) && put(f, horizons.data(), horizons.size())
+		 && put(f, planes.data(), (size_t) ValuePlanes::nPlanes * planes.rows() * planes.cols())
+		 && put(f, searchMean.data(), searchMean.size()));
+  if ((0 != fclose(f)) || !ok || (0 != rename(temp.c_str(), fileName.c_str())))
+  { std::clog << "BELL: Could not write checkpoint " << fileName << std::endl;
+    remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+bool
+MatrixCheckpoint::read (std::string fileName)
+{
+  FILE *f (fopen(fileName.c_str(), "rb"));
+  if (!f)
+    return false;
+  char     m[sizeof(magic)];
+  uint32_t v, keyLength;
+  int32_t  shape[3];
+  double   interval[2];
+  bool ok (get(f, m, sizeof(m)) && (0 == memcmp(m, magic, sizeof(magic))) && get(f, &v, 1) && (version == v)
+	   && get(f, &keyLength, 1) && (keyLength == key.size()));
+  if (ok)
+  { std::string k (keyLength, ' ');
+    ok = get(f, &k[0], keyLength) && (k == key) && get(f, shape, 3) && (0 <= shape[0])
+      && (shape[1] == planes.rows()) && (shape[2] == planes.cols()) && get(f, interval, 2);
+  }
+  if (ok)
+  { horizons.resize(3 * (size_t) shape[0]);
+    ok = get(f, horizons.data(), horizons.size())
+      && get(f, planes.data(), (size_t) ValuePlanes::nPlanes * planes.rows() * planes.cols())
+      && get(f, searchMean.data(), searchMean.size());
+  }
+  fclose(f);
+  if (!ok)
+  { std::clog << "BELL: Checkpoint " << fileName << " is damaged or was written for another solve; ignored." << std::endl;
+    return false;
+  }
+  steps = shape[0];
+  meanInterval = std::make_pair(interval[0], interval[1]);
+  return true;
+}
@@ -0,0 +1,63 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "value_planes.h"
+#include "wealth.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/***********************************************************************************
+
+  State of the matrix recursion for one angle after some number of rounds,
+  saved so that a long solve can be resumed or extended.
+
+  The recursion is time-homogeneous: after k rounds counted back from the
+  end, the source planes hold the values of a k-round problem.  They are the
+  exact starting point for the remaining rounds of any longer solve on the
+  same wealth arrays, whether that solve was interrupted (resume) or asks for
+  more rounds (extension).  Along with the planes, a checkpoint holds the
+  optima of the search in the last round (hints for a warm start), the range
+  of optimal means, and the values at the start after each round, so that
+  the summary and all horizons come out as if the solve had not stopped.
+
+  A checkpoint is keyed by the utility (its type and angle), by the options
+  that change the values found (tables of rejection curves and their
+  refinement, Newton search, accuracy of the normal functions, precision of
+  the planes) and by the contents of the row and column wealth arrays.
+  Since the wealth arrays are built for the number of rounds, an extended
+  solve keeps the arrays of the solve it extends.  The latest checkpoint of
+  a key replaces the prior one (written to a temporary file, then renamed,
+  so a solve killed while writing leaves the prior one intact).
+
+***********************************************************************************/
+
+class MatrixCheckpoint
+{
+ public:
+  std::string              key;
+  int                      steps;                          // rounds solved, counted back from the end
+  DoubleValuePlanes        planes;                         // source of the next round, whatever the precision of the solve
+  std::vector<double>      searchMean;                     // optima of the search in the last round, by cell
+  std::pair<double,double> meanInterval;                   // range of optimal means so far
+  std::vector<double>      horizons;                       // utility, row and col at the start after each round
+
+  MatrixCheckpoint (std::string const& k, int nRows, int nCols)
+    : key(k), steps(0), planes(nRows,nCols), searchMean(nRows*nCols, 0.0), meanInterval(), horizons() { }
+
+  bool write (std::string fileName) const;
+  bool read  (std::string fileName);                       // false if missing, or written for another key or size
+};
+
+
+//  Key of the solve for a utility and the options changing its values (as text) on the given wealth
+//  arrays, and the file of its checkpoint
+
+std::string
+checkpoint_key (std::string const& utility, DualWealthArray const& rowWealth, DualWealthArray const& colWealth);
+
+std::string
+checkpoint_file (std::string const& key);
+
+#endif
@@ -0,0 +1,60 @@
+#include "frontier.h"
+
+#include <algorithm>
+#include <math.h>
+
+//     FrontierTracer     FrontierTracer     FrontierTracer     FrontierTracer     FrontierTracer
+
+void
+FrontierTracer::add (std::vector<Point> const& points)
+{
+  const bool initial (mPoints.empty());
+  std::vector<char> split (mSplit);                          // flags by interval before adding
+  std::vector<int>  oldIndex (mPoints.size());               // position before adding, -1 if added
+  for (int i=0; i<(int)oldIndex.size(); ++i) oldIndex[i] = i;
+  for (Point const& p : points)
+  { auto it = std::lower_bound(mPoints.begin(), mPoints.end(), p, [] (Point const& a, Point const& b) { return a.angle < b.angle; });
+    oldIndex.insert(oldIndex.begin() + (it - mPoints.begin()), -1);
+    mPoints.insert(it, p);
+  }
+  const int n ((int) mPoints.size());
+  mSplit.assign(std::max(0, n-1), 0);
+  if (initial)                                               // chords of the coarse angles
+  { for (int i=0; i+1<n; ++i)
+      mSplit[i] = (mTolerance < hypot(mPoints[i+1].row - mPoints[i].row, mPoints[i+1].col - mPoints[i].col));
+    return;
+  }
+  for (int i=0; i+1<n; ++i)                                  // intervals not split keep their flag
+    if ((0 <= oldIndex[i]) && (0 <= oldIndex[i+1]))
+      mSplit[i] = split[oldIndex[i]];
+  for (int i=1; i+1<n; ++i)                                  // a midpoint lies between the ends of the interval it split
+    if ((oldIndex[i] < 0) && (mTolerance < deviation(mPoints[i-1], mPoints[i], mPoints[i+1])))
+      mSplit[i-1] = mSplit[i] = 1;
+}
+
+
+std::vector<double>
+FrontierTracer::next_angles () const
+{
+  std::vector<double> angles;
+  for (int i=0; i+1<(int)mPoints.size(); ++i)
+  { if ((int)(mPoints.size() + angles.size()) >= mMaxPoints)
+      break;
+    const double gap (mPoints[i+1].angle - mPoints[i].angle);
+    if (mSplit[i] && (2*mMinStep <= gap))
+      angles.push_back(mPoints[i].angle + gap/2);
+  }
+  return angles;
+}
+
+
+double
+FrontierTracer::deviation (Point const& a, Point const& m, Point const& b)
+{
+  const double dr (b.row - a.row), dc (b.col - a.col);
+  const double len2 (dr*dr + dc*dc);
+  double t (0.0);                                            // nearest point of the chord is a + t (b-a)
+  if (0.0 < len2)
+    t = std::min(1.0, std::max(0.0, ((m.row - a.row)*dr + (m.col - a.col)*dc) / len2));
+  return hypot(m.row - (a.row + t*dr), m.col - (a.col + t*dc));
+}
@@ -0,0 +1,55 @@
+#ifndef _FRONTIER_H_
+#define _FRONTIER_H_
+
+#include <vector>
+
+/***********************************************************************************
+
+  Adaptive choice of angles that traces the frontier of the feasible set.
+
+  Each angle gives a point (row, col) of the risks at the start.  Successive
+  points are joined by chords; where the frontier bends sharply between two
+  angles, the chord misses it.  The tracer starts from a coarse set of angles
+  and asks for the midpoint of every interval still to be resolved.  Once the
+  point at a midpoint is known, the interval is resolved if that point lies
+  within the tolerance of the chord between its neighbours; otherwise both
+  halves are split again.  Initial intervals are split unless their chord is
+  itself shorter than the tolerance.
+
+  Intervals narrower than the smallest step are resolved regardless (the
+  frontier may have a corner there), and the tracer asks for no more angles
+  once it holds the largest number of points.  All midpoints of a pass are
+  asked for together, so that they can be solved in one sweep.
+
+***********************************************************************************/
+
+class FrontierTracer
+{
+ public:
+  struct Point { double angle, row, col; };
+
+ private:
+  const double         mTolerance;                 // distance from the chord
+  const double         mMinStep;                   // smallest gap between angles
+  const int            mMaxPoints;
+  std::vector<Point>   mPoints;                    // sorted by angle
+  std::vector<char>    mSplit;                     // interval from point i to i+1 needs a midpoint
+
+ public:
+
+  FrontierTracer (double tolerance, double minStep, int maxPoints)
+    : mTolerance(tolerance), mMinStep(minStep), mMaxPoints(maxPoints), mPoints(), mSplit() { }
+
+  std::vector<Point> const& points() const { return mPoints; }
+
+  // adds the solved points of a pass (the coarse angles, or the midpoints asked for)
+  void add (std::vector<Point> const& points);
+
+  // midpoints of the intervals still to resolve; empty once the frontier is resolved
+  std::vector<double> next_angles () const;
+
+  // distance from m to the chord from a to b
+  static double deviation (Point const& a, Point const& m, Point const& b);
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "lockstep_search.h"
+
+#include <algorithm>
+
+//     LockstepSearch     LockstepSearch     LockstepSearch     LockstepSearch     LockstepSearch
+
+void
+LockstepSearch::find_maxima (VectorUtility const& utility, VectorLanes const& lanes, double *mu, double *util)
+{
+  for (int i=0; i<lanes.n; i += batchSize)
+  { const int count (std::min(batchSize, lanes.n - i));
+    find_batch_maxima(utility, lanes.offset(i,count), mu+i, util+i);
+  }
+}
+
+
+void
+LockstepSearch::find_batch_maxima (VectorUtility const& utility, VectorLanes const& lanes, double *mu, double *util)
+{
+  const double g (0.6180339887498949);
+  const int    n (lanes.n);
+  double x[batchSize] = { 0 }, fx[batchSize];                     // point evaluated in this step
+  double bestX[batchSize], bestF[batchSize];                       // best grid point
+  // coarse grid, same points for every lane
+  for (int i=0; i<n; ++i) x[i] = mInterval.first;
+  utility.evaluate(lanes, x, bestF);
+  for (int i=0; i<n; ++i) bestX[i] = mInterval.first;
+  mEvaluations += n;
+  for (double m = mInterval.first + mGridSize; m <= mInterval.second + 1e-12; m += mGridSize)
+  { for (int i=0; i<n; ++i) x[i] = m;
+    utility.evaluate(lanes, x, fx);
+    mEvaluations += n;
+    for (int i=0; i<n; ++i)
+      if (fx[i] > bestF[i]) { bestF[i] = fx[i]; bestX[i] = m; }
+  }
+  // golden section within one grid step of the best grid point, in lockstep
+  double a[batchSize], b[batchSize], x1[batchSize], x2[batchSize], f1[batchSize], f2[batchSize];
+  for (int i=0; i<n; ++i)
+  { a[i]  = std::max(mInterval.first , bestX[i] - mGridSize);
+    b[i]  = std::min(mInterval.second, bestX[i] + mGridSize);
+    x1[i] = b[i] - g*(b[i]-a[i]);
+    x2[i] = a[i] + g*(b[i]-a[i]);
+  }
+  utility.evaluate(lanes, x1, f1);
+  utility.evaluate(lanes, x2, f2);
+  mEvaluations += 2*n;
+  for (int it=0; it<mMaxIterations; ++it)
+  { int active (0);
+    bool moveLo[batchSize], stepped[batchSize];
+    for (int i=0; i<n; ++i)
+    { stepped[i] = ((b[i]-a[i]) > mTolerance);
+      if (!stepped[i])                                             // masked: x at a point already evaluated
+      { x[i] = x1[i]; moveLo[i] = false;
+	continue;
+      }
+      ++active;
+      moveLo[i] = (f1[i] < f2[i]);
+      if (moveLo[i])
+      { a[i] = x1[i]; x1[i] = x2[i]; f1[i] = f2[i]; x[i] = x2[i] = a[i] + g*(b[i]-a[i]); }
+      else
+      { b[i] = x2[i]; x2[i] = x1[i]; f2[i] = f1[i]; x[i] = x1[i] = b[i] - g*(b[i]-a[i]); }
+    }
+    if (0 == active) break;
+    utility.evaluate(lanes, x, fx);
+    mEvaluations += active;
+    for (int i=0; i<n; ++i)
+    { if (!stepped[i]) continue;
+      if (moveLo[i]) f2[i] = fx[i]; else f1[i] = fx[i];
+    }
+  }
+  for (int i=0; i<n; ++i)
+  { const bool first (f1[i] > f2[i]);
+    mu[i]   = first ? x1[i] : x2[i];
+    util[i] = first ? f1[i] : f2[i];
+    if (util[i] < bestF[i]) { mu[i] = bestX[i]; util[i] = bestF[i]; }
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef _LOCKSTEP_SEARCH_H_
+#define _LOCKSTEP_SEARCH_H_
+
+#include "utility.h"     // VectorUtility, VectorLanes
+
+#include <utility>
+
+/***********************************************************************************
+
+  Golden section search run in lockstep over a batch of vector utilities.
+
+  The columns of a row of the vector recursion are independent and evaluate
+  the same utility with different constants (VectorLanes).  The search moves
+  the brackets of a batch of columns together: every lane is evaluated at the
+  same points of the coarse grid, then each lane takes its own golden section
+  steps from the best grid point, one evaluation per lane per step.  Lanes
+  whose bracket is already short enough are masked and keep their values.
+  Each step thus calls VectorUtility::evaluate on arrays of batchSize means,
+  with z_alpha of each bid computed once rather than at every evaluation.
+
+  The search is the same as Line_Search::GoldenSection with the initial grid,
+  so optima agree with it to the tolerance.
+
+***********************************************************************************/
+
+class LockstepSearch
+{
+ public:
+  static const int batchSize = 16;
+
+ private:
+  const double                    mTolerance;
+  const std::pair<double,double>  mInterval;
+  const double                    mGridSize;
+  const int                       mMaxIterations;
+  long                            mEvaluations;          // lane evaluations
+
+ public:
+
+  LockstepSearch (double tolerance, std::pair<double,double> interval, double gridSize, int maxIterations)
+    : mTolerance(tolerance), mInterval(interval), mGridSize(gridSize), mMaxIterations(maxIterations), mEvaluations(0) { }
+
+  long evaluations() const { return mEvaluations; }
+
+  // fills mu[i], util[i] with the maximum for each lane, in batches of batchSize lanes
+  void find_maxima (VectorUtility const& utility, VectorLanes const& lanes, double *mu, double *util);
+
+ private:
+  void find_batch_maxima (VectorUtility const& utility, VectorLanes const& lanes, double *mu, double *util);
+};
+
+#endif
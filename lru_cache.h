@@ -0,0 +1,100 @@
+#ifndef _LRU_CACHE_H_
+#define _LRU_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+/***********************************************************************************
+
+  Cache of read-only items keyed by text, dropping the least recently used
+  once it holds more than its capacity.
+
+  Items are shared: a caller keeps the item it was given for as long as it
+  needs it, even if the cache drops it meanwhile.  Threads may use a cache at
+  once.  An item not held is made outside the lock, so that other threads can
+  use the cache while it is built; should two threads make the same item at
+  once, both use the first one put in the cache.  A capacity of 0 makes every
+  item anew.
+
+***********************************************************************************/
+
+template <class T>
+class LruCache
+{
+  typedef std::pair<std::string, std::shared_ptr<const T>> Entry;
+
+  const int                   mCapacity;
+  std::list<Entry>            mEntries;                    // most recently used first
+  std::map<std::string, typename std::list<Entry>::iterator> mIndex;
+  long                        mHits, mMisses;
+  mutable std::mutex          mMutex;
+
+ public:
+
+  explicit LruCache (int capacity)
+    : mCapacity(capacity), mEntries(), mIndex(), mHits(0), mMisses(0), mMutex() { }
+
+  LruCache (LruCache const&) = delete;
+  LruCache& operator=(LruCache const&) = delete;
+
+  int  capacity() const { return mCapacity; }
+  int  size()     const { std::lock_guard<std::mutex> lock(mMutex); return (int) mEntries.size(); }
+  long hits()     const { std::lock_guard<std::mutex> lock(mMutex); return mHits; }
+  long misses()   const { std::lock_guard<std::mutex> lock(mMutex); return mMisses; }
+
+  // item of the key, or the one returned (as a new T*) by make() if not held; sets *hit if given
+  template <class Make>
+  std::shared_ptr<const T> find_or_make (std::string const& key, Make const& make, bool *hit = 0);
+
+ private:
+  std::shared_ptr<const T> find (std::string const& key);                  // null if not held; call locked
+};
+
+
+template <class T>
+std::shared_ptr<const T>
+LruCache<T>::find (std::string const& key)
+{
+  auto it = mIndex.find(key);
+  if (it == mIndex.end())
+    return std::shared_ptr<const T>();
+  mEntries.splice(mEntries.begin(), mEntries, it->second);                  // now most recent
+  return it->second->second;
+}
+
+
+template <class T>
+template <class Make>
+std::shared_ptr<const T>
+LruCache<T>::find_or_make (std::string const& key, Make const& make, bool *hit)
+{
+  { std::lock_guard<std::mutex> lock(mMutex);
+    std::shared_ptr<const T> item (find(key));
+    if (hit) *hit = (bool) item;
+    if (item)
+    { ++mHits;
+      return item;
+    }
+    ++mMisses;
+  }
+  std::shared_ptr<const T> made (make());
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mCapacity <= 0)
+    return made;
+  std::shared_ptr<const T> other (find(key));                               // made by another thread meanwhile
+  if (other)
+    return other;
+  mEntries.push_front(std::make_pair(key, made));
+  mIndex[key] = mEntries.begin();
+  while (mCapacity < (int) mEntries.size())
+  { mIndex.erase(mEntries.back().first);
+    mEntries.pop_back();
+  }
+  return made;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef MEAN_SEARCH_TEMPLATE_H
+#define MEAN_SEARCH_TEMPLATE_H
+
+#include "mean_search.h"
+#include "line_search.Template.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+template <class F>
+std::pair<double,double>
+MeanSearch::find_maximum (F const& f, double hint)
+{
+  return find_maximum(f, hint, hint, 0);
+}
+
+
+template <class F>
+std::pair<double,double>
+MeanSearch::find_maximum (F const& f, double hintLo, double hintHi, int *rival)
+{
+  ++mStats.searches;
+  if ((hintLo <= 0.0) || (hintHi < hintLo) || (mHalfWidth <= 0.0))
+    return full_search(f);
+  ++mStats.hinted;
+  CountedFunction<F> g (f, &mStats.evaluations);
+  double lo (std::max(mInterval.first , hintLo - mHalfWidth));
+  double hi (std::min(mInterval.second, hintHi + mHalfWidth));
+  double x  (std::min(std::max(0.5*(hintLo+hintHi), lo + 0.1*(hi-lo)), hi - 0.1*(hi-lo)));   // keep start inside
+  double fLo (g(lo)), fX (g(x)), fHi (g(hi));
+  for (int widen=0; widen<mMaxWidenings; ++widen)                  // move an end out while f rises toward it
+  { const double width (hi-lo);
+    if ((fX < fHi) && (fLo <= fHi) && (hi < mInterval.second))
+    { lo = x; fLo = fX; x = hi; fX = fHi;
+      hi = std::min(mInterval.second, hi + width); fHi = g(hi);
+    }
+    else if ((fX < fLo) && (fHi <= fLo) && (mInterval.first < lo))
+    { hi = x; fHi = fX; x = lo; fX = fLo;
+      lo = std::max(mInterval.first, lo - width); fLo = g(lo);
+    }
+    else break;
+    ++mStats.widened;
+  }
+  std::pair<double,double> local (0.0,0.0);
+  bool found (true);
+  if ((fLo <= fX) && (fHi <= fX))
+    local = local_search(g, lo, x, fX, hi);
+  else if ((fX < fLo) && (fHi <= fLo) && (lo == mInterval.first))
+    local = std::make_pair(lo, fLo);
+  else if ((fX < fHi) && (fLo <= fHi) && (hi == mInterval.second))
+    local = std::make_pair(hi, fHi);
+  else found = false;
+  if (found && beats_rival(g, local.first, rival))
+    return local;
+  ++mStats.fallbacks;
+  if (rival) *rival = -1;                                          // modes have changed; scan next time
+  return full_search(f);
+}
+
+
+template <class F>
+std::pair<double,double>
+MeanSearch::refine_maximum (F const& f, double lo, double x, double hi)
+{
+  ++mStats.searches;
+  CountedFunction<F> g (f, &mStats.evaluations);
+  lo = std::max(lo, mInterval.first);
+  hi = std::min(hi, mInterval.second);
+  const double fLo (g(lo)), fX (g(x)), fHi (g(hi));
+  if ((fLo <= fX) && (fHi <= fX))
+    return local_search(g, lo, x, fX, hi);
+  return (fLo < fHi) ? std::make_pair(hi, fHi) : std::make_pair(lo, fLo);
+}
+
+
+template <class F>
+std::pair<double,double>
+MeanSearch::full_search (F const& f)
+{
+  CountedFunction<F> g (f, &mStats.evaluations);
+  if (!mNewton)
+    return mFullSearch.find_maximum(g);
+  double best (mInterval.first), fBest (g(best));                // same coarse grid, then Newton near the best
+  for (double mu=mInterval.first+mGridSize; mu<mInterval.second+0.5*mGridSize; mu += mGridSize)
+  { const double x (std::min(mu, mInterval.second)), fx (g(x));
+    if (fx > fBest) { best = x; fBest = fx; }
+  }
+  return newton_search(g, std::max(mInterval.first, best-mGridSize), best, std::min(mInterval.second, best+mGridSize));
+}
+
+
+template <class F>
+std::pair<double,double>
+MeanSearch::local_search (F const& f, double a, double x, double fx, double b)
+{
+  if (mNewton)
+    return newton_search(f, a, x, b);
+  return bracketed_search(f, a, x, fx, b);
+}
+
+
+//  Newton's method for a zero of f' on [a,b] starting from x, safeguarded by keeping the
+//  zero bracketed by the sign of f' and bisecting when a Newton step leaves the bracket
+//  or f is not concave at x.  An end of the search interval is the maximum if f' points
+//  there from x and again at the end.
+
+template <class F>
+std::pair<double,double>
+MeanSearch::newton_search (F const& f, double a, double x, double b)
+{
+  const int maxIterations (50);
+  auto d (f.derivatives(x));
+  double best (x), fBest (d.value);
+  bool checkedEnd (false);
+  for (int it=0; it<maxIterations; ++it)
+  { if (0 < d.first) a = x; else b = x;
+    if (!checkedEnd && (((d.first <= 0) && (a == mInterval.first)) || ((0 < d.first) && (b == mInterval.second))))
+    { checkedEnd = true;
+      const double end ((d.first <= 0) ? a : b);
+      auto dEnd (f.derivatives(end));
+      if ((dEnd.first <= 0) == (d.first <= 0))
+      { if (dEnd.value > fBest) { best = end; fBest = dEnd.value; }
+	break;
+      }
+    }
+    double next (0.5*(a+b));
+    if (d.second < 0)
+    { const double newton (x - d.first/d.second);
+      if ((a < newton) && (newton < b)) next = newton;
+    }
+    const double step (next - x);
+    x = next;
+    d = f.derivatives(x);
+    if (d.value > fBest) { best = x; fBest = d.value; }
+    if ((fabs(step) < mTolerance/4) || (b-a < mTolerance))
+      break;
+  }
+  return std::make_pair(best, fBest);
+}
+
+
+//  True if the full search would settle on the mode holding x: the better of the two grid
+//  points around x beats every other grid point checked, the first winning a tie as in the
+//  full search.  Given the rival (the best other grid point found by the last hinted search
+//  of this state), only it, its neighbours and the ends of the grid are checked; without one,
+//  every other grid point and the ends, about half the cost of the grid of the full search.
+//  The best point checked becomes the rival, so later searches refine it.
+
+template <class F>
+bool
+MeanSearch::beats_rival (F const& f, double x, int *rival) const
+{
+  const int n (number_of_grid_points());
+  const int near (std::min(n-1, (int) floor((x - mInterval.first) / mGridSize)));
+  int iLocal (near);
+  double fLocal (f(grid_point(near)));
+  if (near+1 < n)
+  { const double fNext (f(grid_point(near+1)));
+    if (fLocal < fNext) { iLocal = near+1; fLocal = fNext; }
+  }
+  std::vector<int> checks;
+  if (rival && (0 <= *rival))
+  { const int r (*rival);
+    const int candidates[5] = { 0, r-1, r, r+1, n-1 };
+    for (int i : candidates)
+      if ((0 <= i) && (i < n) && (i != near) && (i != near+1) && (checks.empty() || (checks.back() < i)))
+	checks.push_back(i);
+  }
+  else
+  { for (int i=0; i<n; i+=2)                                       // every other point, then the last
+      if ((i != near) && (i != near+1)) checks.push_back(i);
+    if ((1 == (n-1) % 2) && (n-1 != near) && (n-1 != near+1)) checks.push_back(n-1);
+  }
+  int iBest (-1);
+  double fBest (0.0);
+  for (int i : checks)
+  { const double fi (f(grid_point(i)));
+    if ((iBest < 0) || (fBest < fi)) { iBest = i; fBest = fi; }
+  }
+  if (rival) *rival = iBest;
+  return (iBest < 0) || (fBest < fLocal) || ((fBest == fLocal) && (iLocal < iBest));
+}
+
+
+//  Brent's method (golden section with parabolic steps) for the maximum of f on [a,b]
+//  given an interior x with f(x) at least f(a) and f(b).
+
+template <class F>
+std::pair<double,double>
+MeanSearch::bracketed_search (F const& f, double a, double x, double fx, double b)
+{
+  const double goldRatio (0.3819660112501051);
+  const int    maxIterations (100);
+  const double tol1 (mTolerance/4);                                // final bracket about mTolerance wide
+  const double tol2 (2*tol1);
+  double w (x), v (x), fw (fx), fv (fx);
+  double d (0.0), e (0.0);
+  for (int it=0; it<maxIterations; ++it)
+  { const double xm (0.5*(a+b));
+    if (fabs(x-xm) <= tol2 - 0.5*(b-a))
+      break;
+    bool golden (true);
+    if (fabs(e) > tol1)                                            // try parabola through x, w, v
+    { double r ((x-w)*(fv-fx));                                    // signs flipped: maximizing
+      double q ((x-v)*(fw-fx));
+      double p ((x-v)*q - (x-w)*r);
+      q = 2*(q-r);
+      if (q > 0) p = -p;
+      q = fabs(q);
+      const double eLast (e);
+      e = d;
+      if ((fabs(p) < fabs(0.5*q*eLast)) && (p > q*(a-x)) && (p < q*(b-x)))
+      { d = p/q;
+	const double u (x+d);
+	if ((u-a < tol2) || (b-u < tol2))
+	  d = (xm > x) ? tol1 : -tol1;
+	golden = false;
+      }
+    }
+    if (golden)
+    { e = (x >= xm) ? a-x : b-x;
+      d = goldRatio * e;
+    }
+    const double u  ((fabs(d) >= tol1) ? x+d : x + ((d > 0) ? tol1 : -tol1));
+    const double fu (f(u));
+    if (fu >= fx)
+    { if (u >= x) a = x; else b = x;
+      v = w; fv = fw;
+      w = x; fw = fx;
+      x = u; fx = fu;
+    }
+    else
+    { if (u < x) a = u; else b = u;
+      if ((fu >= fw) || (w == x))
+      { v = w; fv = fw;
+	w = u; fw = fu;
+      }
+      else if ((fu >= fv) || (v == x) || (v == w))
+      { v = u; fv = fu;
+      }
+    }
+  }
+  return std::make_pair(x, fx);
+}
+
+#endif
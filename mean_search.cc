@@ -0,0 +1,16 @@
+#include "mean_search.h"
+
+//     SearchStats     SearchStats     SearchStats     SearchStats     SearchStats     SearchStats
+
+void
+SearchStats::print_to (std::ostream& os) const
+{
+  os << searches << " searches with " << evaluations << " evaluations ("
+     << ((searches > 0) ? (double) evaluations / (double) searches : 0.0) << " per search)";
+  if (hinted > 0)
+    os << "; " << hinted << " started from hints, " << widened << " brackets widened, " << fallbacks << " fell back to full search ("
+       << 100.0 * (double) fallbacks / (double) hinted << "%)";
+  if (pruned > 0)
+    os << "; " << pruned << " skipped as mu=0 is optimal ("
+       << 100.0 * (double) pruned / (double) (searches + pruned) << "% of cells)";
+}
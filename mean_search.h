@@ -0,0 +1,190 @@
+#ifndef _MEAN_SEARCH_H_
+#define _MEAN_SEARCH_H_
+
+#include "line_search.h"
+
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <math.h>
+
+/***********************************************************************************
+
+  Search for the mean that maximizes a utility over the search interval.
+
+  Without a hint, this is the golden section search with its initial grid.
+  A hint is a range of means expected to hold the optimum: the optimum at
+  this state found in the prior round (warm start), or the optima at the
+  neighbouring states already solved in this round (monotone policy).  The
+  search checks a short bracket around the range; while the utility rises
+  toward an end of the bracket, that end moves out (a few times at most, in
+  case the policy is not monotone after all).  If the bracket then holds a
+  maximum, Brent's method finds it; if the bracket rises to an end of the
+  search interval, that end is the candidate.  The utility is often bimodal
+  (mu near zero or mu large), so a candidate is accepted only if the full
+  search would settle on the same mode: the grid points next to it must beat
+  those of the other mode, ties going to the first as in the full search.
+  The caller may keep the grid point of the other mode (the rival) for each
+  state, so that later searches check only it, its neighbours and the ends
+  of the grid; the first search of a state checks every other grid point.  If the candidate loses, or the
+  bracket holds no maximum, the search falls back to the full grid scan.
+
+  With the Newton option, local searches use the first two derivatives of the
+  utility (f.derivatives(mu) returns value, first and second) in place of
+  golden section or Brent steps, and the full search refines the best point
+  of its coarse grid the same way.  An evaluation then includes derivatives.
+  The grid keeps its spacing: the vector utility can peak at a kink (f' jumps
+  from positive to negative), which a sparser grid of signs of f' misses.  So
+  a full search still costs the 20 or so points of the grid; searches that
+  start from a table or a hint take 5-15.
+
+  Counts of evaluations and fallbacks accumulate in SearchStats.
+
+  A MeanPolicy keeps the optima of every round of one solve, so that the next
+  solve of a nearby problem (a slightly different angle) can use them as hints.
+
+***********************************************************************************/
+
+struct SearchStats
+{
+  long searches;          // calls with or without a hint
+  long hinted;            // calls with a hint that was used to bracket
+  long widened;           // times an end of a bracket moved out
+  long fallbacks;         // hinted calls whose bracket missed
+  long pruned;            // searches skipped since a bound showed mu=0 is optimal
+  long evaluations;       // utility evaluations made by the search
+
+  SearchStats() : searches(0), hinted(0), widened(0), fallbacks(0), pruned(0), evaluations(0) { }
+
+  SearchStats& operator+=(SearchStats const& s)
+    { searches += s.searches; hinted += s.hinted; widened += s.widened;
+      fallbacks += s.fallbacks; pruned += s.pruned; evaluations += s.evaluations; return *this; }
+
+  void print_to (std::ostream& os) const;
+};
+
+inline
+std::ostream&
+operator<< (std::ostream& os, SearchStats const& s)
+{
+  s.print_to(os);
+  return os;
+}
+
+
+//  Wraps a utility to count the calls made by a search
+
+template <class F>
+class CountedFunction: public std::unary_function<double,double>
+{
+  F const& mF;
+  long    *mCount;
+
+ public:
+  CountedFunction (F const& f, long *count) : mF(f), mCount(count) { }
+
+  double operator()(double mu) const { ++*mCount; return mF(mu); }
+
+  auto derivatives (double mu) const -> decltype(mF.derivatives(mu)) { ++*mCount; return mF.derivatives(mu); }
+};
+
+
+//  Range of means expected to hold the optimum; empty until a mean is added
+
+class MeanHint
+{
+  double mLo, mHi;
+
+ public:
+  MeanHint() : mLo(1.0), mHi(0.0) { }
+
+  double lo() const { return mLo; }
+  double hi() const { return mHi; }
+
+  bool empty() const { return mHi < mLo; }
+
+  void add (double mu)                   // mu <= 0 is not a hint
+    { if (mu <= 0.0) return;
+      if (mHi < mLo) mLo = mHi = mu;
+      else { mLo = std::min(mLo, mu); mHi = std::max(mHi, mu); }
+    }
+};
+
+
+//  Optima found by the searches of a solve, by round (counted from the start) and state;
+//  stored as floats since they only serve as hints.  Rounds not stored give no hint.
+
+class MeanPolicy
+{
+  std::vector< std::vector<float> > mMeans;
+
+ public:
+
+  bool   has  (int round)        const { return (round < (int) mMeans.size()) && !mMeans[round].empty(); }
+  double mean (int round, int k) const { return mMeans[round][k]; }
+
+  void   store (int round, std::vector<double> const& searchMean)
+    { if ((int) mMeans.size() <= round) mMeans.resize(round+1);
+      mMeans[round].assign(searchMean.begin(), searchMean.end());
+    }
+};
+
+
+class MeanSearch
+{
+  Line_Search::GoldenSection      mFullSearch;
+  const double                    mTolerance;
+  const std::pair<double,double>  mInterval;
+  const double                    mHalfWidth;           // bracket is hint +/- this much
+  const double                    mGridSize;            // spacing of coarse grid in full search
+  const int                       mMaxWidenings;
+  const bool                      mNewton;              // local searches use derivatives of f
+  SearchStats                     mStats;
+
+ public:
+
+  MeanSearch (Line_Search::GoldenSection const& fullSearch, double tolerance, std::pair<double,double> interval,
+	      double gridSize, double halfWidth, bool newton = false)
+    : mFullSearch(fullSearch), mTolerance(tolerance), mInterval(interval), mHalfWidth(halfWidth), mGridSize(gridSize),
+      mMaxWidenings(2), mNewton(newton), mStats() { }
+
+  SearchStats const& stats()  const { return mStats; }
+
+  void count_pruned()               { ++mStats.pruned; }
+
+  // returns opt, f(opt); hint <= 0 means no hint
+  template <class F>
+    std::pair<double,double> find_maximum (F const& f, double hint = 0.0);
+
+  // optimum expected in [hintLo, hintHi]; no hint if hintLo <= 0 or hintHi < hintLo.  rival, if
+  // given, keeps the grid point of the other mode at this state from one search to the next (-1 if none)
+  template <class F>
+    std::pair<double,double> find_maximum (F const& f, double hintLo, double hintHi, int *rival = 0);
+
+  // local search in [lo,hi] from x, the best point of a grid with spacing about (hi-lo)/2
+  template <class F>
+    std::pair<double,double> refine_maximum (F const& f, double lo, double x, double hi);
+
+ private:
+  template <class F>
+    std::pair<double,double> full_search (F const& f);
+
+  int    number_of_grid_points () const { return 1 + (int) floor((mInterval.second - mInterval.first) / mGridSize + 1.0e-9); }
+  double grid_point (int i)      const { return mInterval.first + i * mGridSize; }
+
+  template <class F>
+    bool beats_rival (F const& f, double x, int *rival) const;
+
+  template <class F>
+    std::pair<double,double> local_search (F const& f, double lo, double x, double fx, double hi);
+
+  template <class F>
+    std::pair<double,double> newton_search (F const& f, double lo, double x, double hi);
+
+  template <class F>
+    std::pair<double,double> bracketed_search (F const& f, double lo, double x, double fx, double hi);
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PARALLEL_TEMPLATE_H
+#define PARALLEL_TEMPLATE_H
+
+#include "parallel.h"
+
+
+template <class F>
+void
+parallel_for (int nItems, WorkerPool &pool, F const& f)
+{
+  if (pool.number_of_workers() <= 1)
+  { for (int i=0; i<nItems; ++i)
+      f(0,i);
+    return;
+  }
+  WorkStealingScheduler scheduler (nItems, pool.number_of_workers());
+  pool.run([&scheduler, &f] (int w) { int i; while (scheduler.next(w,&i)) f(w,i); });
+}
+
+#endif
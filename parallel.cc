@@ -0,0 +1,112 @@
+#include "parallel.h"
+
+//     WorkStealingScheduler     WorkStealingScheduler     WorkStealingScheduler     WorkStealingScheduler
+
+WorkStealingScheduler::WorkStealingScheduler (int nItems, int nWorkers)
+  : mBlocks()
+{
+  if (nWorkers < 1) nWorkers = 1;
+  int begin = 0;
+  for (int w=0; w<nWorkers; ++w)
+  { int end = (int) (((long) nItems * (w+1)) / nWorkers);
+    mBlocks.push_back( std::unique_ptr<Block>(new Block()) );
+    mBlocks.back()->front = begin;
+    mBlocks.back()->back  = end;
+    begin = end;
+  }
+}
+
+bool
+WorkStealingScheduler::next (int worker, int *item)
+{
+  return take_front(worker, item) || steal_back(worker, item);
+}
+
+bool
+WorkStealingScheduler::take_front (int worker, int *item)
+{
+  Block &b (*mBlocks[worker]);
+  std::lock_guard<std::mutex> guard (b.mutex);
+  if (b.front < b.back)
+  { *item = b.front++;
+    return true;
+  }
+  return false;
+}
+
+bool
+WorkStealingScheduler::steal_back (int worker, int *item)
+{
+  while (true)
+  { int victim = -1, most = 0;
+    for (int w=0; w<(int)mBlocks.size(); ++w)             // sizes read without lock; only a hint
+    { if (w == worker) continue;
+      int left = mBlocks[w]->back - mBlocks[w]->front;
+      if (left > most) { most = left; victim = w; }
+    }
+    if (victim < 0) return false;
+    Block &b (*mBlocks[victim]);
+    std::lock_guard<std::mutex> guard (b.mutex);
+    if (b.front < b.back)
+    { *item = --b.back;
+      return true;
+    }                                                      // lost the race; look again
+  }
+}
+
+
+//     WorkerPool     WorkerPool     WorkerPool     WorkerPool     WorkerPool     WorkerPool     WorkerPool
+
+WorkerPool::WorkerPool (int nWorkers)
+  : mWorkers(nWorkers < 1 ? 1 : nWorkers), mThreads(), mMutex(), mStart(), mDone(),
+    mJob(0), mGeneration(0), mBusy(0), mStopping(false)
+{
+  for (int w=1; w<mWorkers; ++w)
+    mThreads.push_back(std::thread(&WorkerPool::work, this, w));
+}
+
+
+WorkerPool::~WorkerPool()
+{
+  { std::lock_guard<std::mutex> guard (mMutex);
+    mStopping = true;
+  }
+  mStart.notify_all();
+  for (std::thread &t : mThreads)
+    t.join();
+}
+
+
+void
+WorkerPool::run (std::function<void(int)> const& job)
+{
+  { std::lock_guard<std::mutex> guard (mMutex);
+    mJob = &job;
+    mBusy = mWorkers-1;
+    ++mGeneration;
+  }
+  mStart.notify_all();
+  job(0);
+  std::unique_lock<std::mutex> lock (mMutex);
+  mDone.wait(lock, [this] () { return 0 == mBusy; });
+  mJob = 0;
+}
+
+
+void
+WorkerPool::work (int worker)
+{
+  long seen (0);
+  std::unique_lock<std::mutex> lock (mMutex);
+  while (true)
+  { mStart.wait(lock, [this, seen] () { return mStopping || (mGeneration != seen); });
+    if (mStopping) return;
+    seen = mGeneration;
+    std::function<void(int)> const& job (*mJob);
+    lock.unlock();
+    job(worker);
+    lock.lock();
+    if (0 == --mBusy)
+      mDone.notify_one();
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+/***********************************************************************************
+
+  Work-stealing scheduler used to spread the cells of a Bellman round over threads.
+
+  Each worker owns a contiguous block of the items [0,n) and takes work from the
+  front of its block; once its own block is empty, it steals from the back of the
+  block that has the most items left.  The cost of an item varies a lot (regions
+  with optimal mean 0 are cheap), so a static split leaves threads idle.
+
+***********************************************************************************/
+
+class WorkStealingScheduler
+{
+  struct Block { std::mutex mutex; std::atomic<int> front, back; };    // items [front,back) not yet taken; change under mutex
+
+  std::vector< std::unique_ptr<Block> > mBlocks;
+
+ public:
+
+  WorkStealingScheduler (int nItems, int nWorkers);
+
+  int  number_of_workers () const { return (int) mBlocks.size(); }
+
+  bool next (int worker, int *item);                       // false when no work remains
+
+ private:
+  bool take_front (int worker, int *item);
+  bool steal_back (int worker, int *item);
+};
+
+
+//  Threads kept for the rounds of a solve, so that each round hands its items to workers
+//  already waiting rather than starting and joining threads.  The thread that calls run is
+//  worker 0; the pool starts the other nWorkers-1 once and stops them when destroyed.
+
+class WorkerPool
+{
+  const int                mWorkers;
+  std::vector<std::thread> mThreads;
+  std::mutex               mMutex;
+  std::condition_variable  mStart, mDone;
+  std::function<void(int)> const* mJob;                    // share of worker w of the current run
+  long                     mGeneration;                    // runs started
+  int                      mBusy;                          // threads yet to finish the current run
+  bool                     mStopping;
+
+ public:
+
+  explicit WorkerPool (int nWorkers);
+  ~WorkerPool();
+
+  WorkerPool (WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+
+  int  number_of_workers () const { return mWorkers; }
+
+  void run (std::function<void(int)> const& job);          // job(w) on every worker; returns when all are done
+
+ private:
+  void work (int worker);
+};
+
+
+//  Calls f(worker, item) for every item in [0,nItems) using the workers of the pool.  With one
+//  worker, runs on the calling thread in order.  f must only write state owned by item or worker.
+
+template <class F>
+void
+parallel_for (int nItems, WorkerPool &pool, F const& f);
+
+
+#endif
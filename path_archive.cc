@@ -0,0 +1,280 @@
+#include "path_archive.h"
+
+#include "eigen_utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using EigenUtils::write_matrix_to_file;
+
+using namespace PathArchiveFormat;
+
+namespace
+{
+  const char magic[8] = { 'B','E','L','L','P','A','T','H' };
+
+  const char* extension[ValuePlanes::nPlanes] = { ".utility", ".row", ".col", ".mean" };
+
+  uint64_t
+  aligned (uint64_t offset, uint64_t align)
+  { return ((offset + align - 1) / align) * align; }
+
+  bool
+  write_bytes (FILE *f, void const* data, uint64_t bytes)
+  { return (0 == bytes) || (fwrite(data, 1, bytes, f) == bytes); }
+}
+
+//     PathArchiveWriter     PathArchiveWriter     PathArchiveWriter     PathArchiveWriter     PathArchiveWriter
+
+PathArchiveWriter::PathArchiveWriter (std::string fileName, std::string config, int nRounds, int rows, int cols, bool meansOnly,
+				      DualWealthArray const& rowWealth, DualWealthArray const& colWealth)
+  : mFile(fopen(fileName.c_str(), "wb")), mFileName(fileName), mOk(mFile != 0), mHeader(), mIndex(nRounds+1, 0), mBuffer(),
+    mEnd(0), mBytes(0.0), mSeconds(0.0)
+{
+  if (!mFile)
+  { std::clog << "BELL: Could not open path archive " << fileName << std::endl;
+    return;
+  }
+  memset(&mHeader, 0, sizeof(mHeader));
+  memcpy(mHeader.magic, magic, sizeof(magic));
+  mHeader.version = version;
+  mHeader.byteOrder = byteOrder;
+  mHeader.nRounds = nRounds;
+  mHeader.rows = rows;
+  mHeader.cols = cols;
+  for (int p=0; p<ValuePlanes::nPlanes; ++p)
+    mHeader.planes[p] = meansOnly ? -1 : p;
+  if (meansOnly)
+  { mHeader.nPlanes = 1;
+    mHeader.planes[0] = ValuePlanes::mean;
+    mBuffer.resize((size_t) rows*cols);
+  }
+  else
+    mHeader.nPlanes = ValuePlanes::nPlanes;
+  mHeader.roundBytes = (uint64_t) rows * cols * mHeader.nPlanes * sizeof(float);
+  const std::vector<char> zeros (headerSize, 0);                          // header written on close
+  mOk = write_bytes(mFile, &zeros[0], headerSize);
+  mEnd = headerSize;
+  write_section(PathArchiveFormat::config, config.data(), config.size(), alignment);
+  write_wealth(PathArchiveFormat::rowWealth, rowWealthText, rowWealth);
+  write_wealth(PathArchiveFormat::colWealth, colWealthText, colWealth);
+}
+
+
+void
+PathArchiveWriter::write_section (Section s, void const* data, uint64_t bytes, uint64_t align)
+{
+  if (!mOk) return;                                                       // file removed on close
+  const uint64_t start (aligned(mEnd, align));
+  if (start > mEnd)
+  { const std::vector<char> zeros (start - mEnd, 0);
+    mOk = write_bytes(mFile, &zeros[0], zeros.size());
+  }
+  mOk = mOk && write_bytes(mFile, data, bytes);
+  mEnd = start + bytes;
+  if (s < nSections)
+  { mHeader.sections[s].offset = start;
+    mHeader.sections[s].bytes  = bytes;
+  }
+}
+
+
+void
+PathArchiveWriter::write_wealth (Section s, Section text, DualWealthArray const& wealth)
+{
+  const int n (wealth.number_wealth_positions());
+  std::vector<char> data (sizeof(WealthHeader) + n * sizeof(WealthEntry), 0);
+  WealthHeader *h (reinterpret_cast<WealthHeader*>(&data[0]));
+  h->n = n;
+  h->zeroIndex = wealth.zero_index();
+  h->initialWealth = wealth.initial_wealth();
+  h->omega = wealth.omega();
+  WealthEntry *e (reinterpret_cast<WealthEntry*>(&data[sizeof(WealthHeader)]));
+  for (int k=0; k<n; ++k)
+  { e[k].wealth      = wealth.wealth(k);
+    e[k].bid         = wealth.bid(k);
+    e[k].rejectIndex = wealth.reject_index(k);
+    e[k].rejectProb  = wealth.reject_prob(k);
+    e[k].bidIndex    = wealth.bid_jumps_to(k);
+    e[k].bidShare    = wealth.bid_jump_share(k);
+  }
+  write_section(s, &data[0], data.size(), alignment);
+  std::ostringstream ss;
+  wealth.write_to(ss, true);                                              // true = as lines
+  const std::string lines (ss.str());
+  write_section(text, lines.data(), lines.size(), alignment);
+}
+
+
+void
+PathArchiveWriter::write_block (uint64_t *offset, ValuePlanes const& planes, bool meansOnly)
+{
+  auto start = std::chrono::steady_clock::now();
+  float const* data (planes.data());
+  if (meansOnly)
+  { const long n ((long) mBuffer.size());
+    for (long i=0; i<n; ++i)
+      mBuffer[i] = data[i*ValuePlanes::nPlanes + ValuePlanes::mean];
+    data = &mBuffer[0];
+  }
+  write_section(nSections, data, mHeader.roundBytes, pageSize);
+  *offset = mEnd - mHeader.roundBytes;
+  mBytes += mHeader.roundBytes;
+  mSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+void
+PathArchiveWriter::put (int round, ValuePlanes const& planes)
+{
+  if (mFile)
+    write_block(&mIndex[round], planes, 1 == mHeader.nPlanes);
+}
+
+
+void
+PathArchiveWriter::put_stationary (ValuePlanes const& planes)
+{
+  if (mFile)
+    write_block(&mIndex[mHeader.nRounds], planes, 1 == mHeader.nPlanes);
+}
+
+
+bool
+PathArchiveWriter::close ()
+{
+  if (!mFile) return mOk;
+  write_section(PathArchiveFormat::index, &mIndex[0], mIndex.size() * sizeof(uint64_t), alignment);
+  mOk = mOk && (0 == fseek(mFile, 0, SEEK_SET)) && write_bytes(mFile, &mHeader, sizeof(mHeader));
+  mOk = (0 == fclose(mFile)) && mOk;
+  mFile = 0;
+  if (!mOk)
+  { std::clog << "BELL: Could not write path archive " << mFileName << "; removed it." << std::endl;
+    remove(mFileName.c_str());
+  }
+  return mOk;
+}
+
+
+//     PathArchive     PathArchive     PathArchive     PathArchive     PathArchive     PathArchive     PathArchive
+
+PathArchive::PathArchive (std::string fileName)
+  : mFd(open(fileName.c_str(), O_RDONLY)), mBase(0), mSize(0), mHeader(0), mIndex(0)
+{
+  for (int p=0; p<ValuePlanes::nPlanes; ++p) mSlot[p] = -1;
+  struct stat st;
+  if ((mFd < 0) || (fstat(mFd, &st) != 0))
+  { std::clog << "BELL: Could not open path archive " << fileName << std::endl;
+    return;
+  }
+  mSize = (uint64_t) st.st_size;
+  if (mSize < (uint64_t) headerSize)
+  { std::clog << "BELL: Path archive " << fileName << " is too short to hold a header" << std::endl;
+    return;
+  }
+  void *base (mmap(0, mSize, PROT_READ, MAP_SHARED, mFd, 0));
+  if (base == MAP_FAILED)
+  { std::clog << "BELL: Could not map path archive " << fileName << std::endl;
+    return;
+  }
+  mBase = static_cast<unsigned char const*>(base);
+  mHeader = reinterpret_cast<Header const*>(mBase);
+  if (!check())
+  { std::clog << "BELL: " << fileName << " is not a version " << version << " path archive written with this byte order" << std::endl;
+    mHeader = 0;
+    return;
+  }
+  mIndex = reinterpret_cast<uint64_t const*>(mBase + mHeader->sections[PathArchiveFormat::index].offset);
+  for (int s=0; s<mHeader->nPlanes; ++s)
+    mSlot[mHeader->planes[s]] = s;
+}
+
+
+PathArchive::~PathArchive()
+{
+  if (mBase) munmap(const_cast<unsigned char*>(mBase), mSize);
+  if (0 <= mFd) ::close(mFd);
+}
+
+
+bool
+PathArchive::check () const
+{
+  if ((memcmp(mHeader->magic, magic, sizeof(magic)) != 0) || (mHeader->version != version) || (mHeader->byteOrder != byteOrder))
+    return false;
+  if ((mHeader->nRounds < 0) || (mHeader->nPlanes < 1) || (ValuePlanes::nPlanes < mHeader->nPlanes))
+    return false;
+  for (int s=0; s<mHeader->nPlanes; ++s)
+    if ((mHeader->planes[s] < 0) || (ValuePlanes::nPlanes <= mHeader->planes[s]))
+      return false;
+  for (int s=0; s<nSections; ++s)
+    if (mSize < mHeader->sections[s].offset + mHeader->sections[s].bytes)
+      return false;
+  if (mHeader->sections[PathArchiveFormat::index].bytes != (mHeader->nRounds + 1) * sizeof(uint64_t))
+    return false;
+  uint64_t const* offsets (reinterpret_cast<uint64_t const*>(mBase + mHeader->sections[PathArchiveFormat::index].offset));
+  for (int round=0; round<=mHeader->nRounds; ++round)
+    if ((0 != offsets[round]) && (mSize < offsets[round] + mHeader->roundBytes))
+      return false;
+  return true;
+}
+
+
+std::string
+PathArchive::text (Section s) const
+{
+  return std::string(reinterpret_cast<char const*>(mBase + mHeader->sections[s].offset), mHeader->sections[s].bytes);
+}
+
+
+WealthHeader const&
+PathArchive::wealth_header (bool row) const
+{
+  return *reinterpret_cast<WealthHeader const*>(mBase + mHeader->sections[row ? rowWealth : colWealth].offset);
+}
+
+
+WealthEntry const*
+PathArchive::wealth_entries (bool row) const
+{
+  return reinterpret_cast<WealthEntry const*>(mBase + mHeader->sections[row ? rowWealth : colWealth].offset + sizeof(WealthHeader));
+}
+
+
+Matrix
+PathArchive::plane_matrix (float const* block, ValuePlanes::Plane p) const
+{
+  const int nRows (mHeader->rows), nCols (mHeader->cols), nPlanes (mHeader->nPlanes), slot (mSlot[p]);
+  Matrix m (nRows, nCols);
+  for (int r=0; r<nRows; ++r)
+    for (int c=0; c<nCols; ++c)
+      m(r,c) = block[((long)r*nCols+c)*nPlanes + slot];
+  return m;
+}
+
+
+void
+PathArchive::write_text (std::string dir) const
+{
+  const std::string config (this->config());
+  for (int round=0; round<mHeader->nRounds; ++round)
+  { if (!has_round(round)) continue;
+    const std::string sr = "_" + std::to_string(round);
+    for (int p=0; p<ValuePlanes::nPlanes; ++p)
+      if (has_plane((ValuePlanes::Plane) p))
+	write_matrix_to_file(dir + config + sr + extension[p], matrix(round, (ValuePlanes::Plane) p));
+  }
+  if (has_stationary())
+    write_matrix_to_file(dir + config + ".stationary_mean", stationary_matrix());
+  for (int row=1; 0<=row; --row)
+  { std::ofstream output (dir + config + (row ? ".row_wealth" : ".col_wealth"), std::ios_base::trunc);
+    output << wealth_text(row);
+  }
+}
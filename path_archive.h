@@ -0,0 +1,167 @@
+#ifndef _PATH_ARCHIVE_H_
+#define _PATH_ARCHIVE_H_
+
+#include "value_planes.h"
+#include "wealth.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/***********************************************************************************
+
+  Path details of the tensor solve held in one binary file (.bellpath) that
+  readers can map into memory, in place of the four text files per round.
+
+  Layout (version 1, native byte order, which the header records):
+    - header of 4096 bytes: magic, version, byte-order mark, the number of
+      rounds, the size of a plane (rows and columns, padding included), which
+      planes each round holds, and a table of sections (offset, bytes);
+    - sections, each aligned to 64 bytes: the configuration, the row and
+      column wealth arrays (a WealthHeader then one WealthEntry per position,
+      giving the bid and the positions a rejection or a bid moves to), the
+      same arrays as the text written to .row_wealth/.col_wealth, and the
+      index of rounds;
+    - one block per round solved, aligned to the 4096-byte page.  A block holds
+      the cells row by row, the planes of a cell next to each other, as in
+      ValuePlanes, so that the value of plane p at (r,c) is the float
+        block + (r * cols + c) * nPlanes + slot(p).
+  The index gives the offset of the block of each round counted from the
+  start, then that of the stationary mean policy; 0 marks a round not
+  solved (the solve stopped once stationary).  With bounded memory, rounds
+  hold only the mean plane.
+
+  The writer streams each round to the file as it is done, so the solve keeps
+  no planes beyond the two in use; the index and header are written on close.
+  Should a write fail (a full disk, say), close reports it and removes the file
+  rather than leave a partial archive.
+  A block is a copy of the planes, so writing costs no formatting.
+
+***********************************************************************************/
+
+namespace PathArchiveFormat
+{
+  const uint32_t version    = 1;
+  const uint32_t byteOrder  = 0x01020304;
+  const int      headerSize = 4096;
+  const int      pageSize   = 4096;
+  const int      alignment  = 64;
+
+  enum Section { config=0, rowWealth=1, colWealth=2, rowWealthText=3, colWealthText=4, index=5, nSections=6 };
+
+  struct SectionEntry { uint64_t offset, bytes; };
+
+  struct Header
+  { char         magic[8];                                 // "BELLPATH"
+    uint32_t     version;
+    uint32_t     byteOrder;
+    int32_t      nRounds;
+    int32_t      rows, cols;                               // of each plane, padding included
+    int32_t      nPlanes;                                  // planes held by each round
+    int32_t      planes[ValuePlanes::nPlanes];             // ValuePlanes::Plane of each slot, -1 if unused
+    uint64_t     roundBytes;
+    SectionEntry sections[nSections];
+  };
+
+  struct WealthHeader
+  { int32_t      n, zeroIndex;
+    double       initialWealth, omega;
+  };
+
+  struct WealthEntry
+  { double       wealth, bid;
+    double       rejectProb, bidShare;
+    int32_t      rejectIndex, bidIndex;
+  };
+}
+
+
+class PathArchiveWriter
+{
+  FILE*                     mFile;
+  std::string               mFileName;
+  bool                      mOk;                           // every write so far succeeded
+  PathArchiveFormat::Header mHeader;
+  std::vector<uint64_t>     mIndex;                        // rounds, then the stationary mean
+  std::vector<float>        mBuffer;                       // block of one round when only some planes are kept
+  uint64_t                  mEnd;
+  double                    mBytes;                        // of round blocks written
+  double                    mSeconds;                      //   ... and the time taken
+
+ public:
+
+  PathArchiveWriter (std::string fileName, std::string config, int nRounds, int rows, int cols, bool meansOnly,
+		     DualWealthArray const& rowWealth, DualWealthArray const& colWealth);
+
+  ~PathArchiveWriter() { close(); }
+
+  bool   is_open()            const { return mFile != 0; }
+  double megabytes()          const { return mBytes / (1024.0*1024.0); }
+  double seconds()            const { return mSeconds; }
+  double round_bytes()        const { return (double) mHeader.roundBytes; }
+
+  void   put (int round, ValuePlanes const& planes);       // round counted from the start
+  void   put_stationary (ValuePlanes const& planes);       // mean policy of the last round solved
+  bool   close ();                                         // false if not written in full, having removed the file
+
+ private:
+  void   write_block (uint64_t *offset, ValuePlanes const& planes, bool meansOnly);
+  void   write_section (PathArchiveFormat::Section s, void const* data, uint64_t bytes, uint64_t align);
+  void   write_wealth  (PathArchiveFormat::Section s, PathArchiveFormat::Section text, DualWealthArray const& wealth);
+};
+
+
+class PathArchive
+{
+  int                               mFd;
+  unsigned char const*              mBase;
+  uint64_t                          mSize;
+  PathArchiveFormat::Header const*  mHeader;
+  uint64_t const*                   mIndex;
+  int                               mSlot[ValuePlanes::nPlanes];      // slot of each plane, -1 if not kept
+
+ public:
+
+  PathArchive (std::string fileName);
+  ~PathArchive();
+
+  PathArchive (PathArchive const&) = delete;
+  PathArchive& operator=(PathArchive const&) = delete;
+
+  bool   is_open()                        const { return mHeader != 0; }
+
+  int    number_of_rounds()               const { return mHeader->nRounds; }
+  int    rows()                           const { return mHeader->rows; }
+  int    cols()                           const { return mHeader->cols; }
+  int    number_of_planes()               const { return mHeader->nPlanes; }
+  bool   has_plane (ValuePlanes::Plane p) const { return 0 <= mSlot[p]; }
+  bool   has_round (int round)            const { return 0 != mIndex[round]; }
+  bool   has_stationary()                 const { return 0 != mIndex[mHeader->nRounds]; }
+
+  std::string config()                    const { return text(PathArchiveFormat::config); }
+  std::string wealth_text (bool row)      const { return text(row ? PathArchiveFormat::rowWealthText : PathArchiveFormat::colWealthText); }
+
+  PathArchiveFormat::WealthHeader const& wealth_header (bool row) const;
+  PathArchiveFormat::WealthEntry  const* wealth_entries(bool row) const;  // wealth_header(row).n of them
+
+  // cells of a round (or stationary policy), row by row, number_of_planes() floats per cell
+  float const* round_data (int round)     const { return reinterpret_cast<float const*>(mBase + mIndex[round]); }
+  float const* stationary_data ()         const { return round_data(mHeader->nRounds); }
+
+  float  value (int round, int r, int c, ValuePlanes::Plane p) const
+    { return round_data(round)[((long)r * mHeader->cols + c) * mHeader->nPlanes + mSlot[p]]; }
+
+  Matrix matrix (int round, ValuePlanes::Plane p)  const { return plane_matrix(round_data(round), p); }
+  Matrix stationary_matrix ()                      const { return plane_matrix(stationary_data(), ValuePlanes::mean); }
+
+  // files of the text layout: <dir><config>_<round>.utility/.row/.col/.mean, .stationary_mean, .row_wealth, .col_wealth
+  void   write_text (std::string dir) const;
+
+ private:
+  std::string text (PathArchiveFormat::Section s) const;
+  Matrix plane_matrix (float const* block, ValuePlanes::Plane p) const;
+  bool   check () const;
+};
+
+#endif
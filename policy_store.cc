@@ -0,0 +1,93 @@
+#include "policy_store.h"
+
+#include <algorithm>
+#include <math.h>
+
+//     PolicyStore     PolicyStore     PolicyStore     PolicyStore     PolicyStore     PolicyStore
+
+void
+PolicyStore::put (int round, ValuePlanes const& planes)
+{
+  Round &r (mRounds[round]);
+  const Matrix m (planes.matrix(ValuePlanes::mean));
+  r.rows = (int) m.rows();
+  r.cols = (int) m.cols();
+  if (mQuantize && encode(m, r))
+    return;
+  if (mQuantize) ++mPlainRounds;
+  r.scale = 0.0;
+  r.codes.clear();
+  r.plain = m;
+}
+
+
+bool
+PolicyStore::encode (Matrix const& m, Round &r)
+{
+  const long n (m.size());
+  float const* x (m.data());
+  float largest (0.0f);
+  for (long i=0; i<n; ++i)
+  { if (!(0.0f <= x[i])) return false;                     // negative or nan
+    largest = std::max(largest, x[i]);
+  }
+  const double scale ((0.0f < largest) ? largest / 65535.0 : 1.0);
+  std::vector<uint16_t> codes;
+  double maxError (0.0);
+  long i (0);
+  while (i < n)
+  { if (x[i] == 0.0f)                                      // run of zeros, up to the largest length a code holds
+    { long j (i);
+      while ((j < n) && (x[j] == 0.0f) && (j-i < 65535)) ++j;
+      codes.push_back(0);
+      codes.push_back((uint16_t) (j-i));
+      i = j;
+    }
+    else
+    { const long q (std::max(1L, std::min(65535L, lround(x[i] / scale))));
+      maxError = std::max(maxError, fabs(q * scale - x[i]));
+      codes.push_back((uint16_t) q);
+      ++i;
+    }
+  }
+  if (mTolerance < maxError)
+    return false;
+  mMaxError = std::max(mMaxError, maxError);
+  r.scale = scale;
+  r.codes.swap(codes);
+  r.codes.shrink_to_fit();
+  r.plain = Matrix();
+  return true;
+}
+
+
+Matrix
+PolicyStore::mean (int round) const
+{
+  Round const& r (mRounds[round]);
+  if (r.scale == 0.0)
+    return r.plain;
+  Matrix m (r.rows, r.cols);
+  float *x (m.data());
+  long i (0);
+  for (size_t k=0; k<r.codes.size(); ++k)
+  { if (r.codes[k] == 0)
+    { const long len (r.codes[++k]);
+      std::fill(x+i, x+i+len, 0.0f);
+      i += len;
+    }
+    else
+      x[i++] = (float) (r.codes[k] * r.scale);
+  }
+  return m;
+}
+
+
+long
+PolicyStore::bytes () const
+{
+  long total (0);
+  for (Round const& r : mRounds)
+    total += (long) r.plain.size() * (long) sizeof(float) + (long) r.codes.size() * (long) sizeof(uint16_t);
+  return total;
+}
@@ -0,0 +1,67 @@
+#ifndef _POLICY_STORE_H_
+#define _POLICY_STORE_H_
+
+#include "value_planes.h"
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************************************
+
+  Optimal means of the matrix recursion, kept round by round.
+
+  Simulating the mean process (simulate_means.R) needs only the optimal mean
+  at each state and round, not the utility, row and column values.  When
+  memory is bounded, the tensor solve keeps the value planes only for the two
+  rounds being read and written, and hands the mean plane of each round to a
+  PolicyStore as the round is done.  Rounds are counted from the start, as in
+  the files written for them.
+
+  Quantized, a round is held as 16-bit codes rather than floats.  Means lie
+  in [0,10], so a code q > 0 stands for q*scale with scale = (largest mean of
+  the round)/65535, a step of at most 1.5e-4.  Code 0 starts a run of zeros
+  (mu=0 is optimal over large regions) and the next code holds its length.
+  Each round is encoded as it arrives, and the largest error of the decoded
+  means is checked against the tolerance (that of the search for the mean,
+  so quantizing adds no more error than the search already allows); a round
+  that fails the check, or holds a negative mean, is kept as floats.
+
+***********************************************************************************/
+
+class PolicyStore
+{
+  struct Round
+  { int                   rows, cols;
+    double                scale;                           // mean of code 1; 0 if kept as floats
+    std::vector<uint16_t> codes;                           // by column, as Matrix stores them
+    Matrix                plain;
+  };
+
+  const bool          mQuantize;
+  const double        mTolerance;                          // largest error allowed for a quantized mean
+  std::vector<Round>  mRounds;
+  double              mMaxError;                           // largest error of the quantized rounds
+  int                 mPlainRounds;                        // rounds kept as floats when quantizing
+
+ public:
+
+  PolicyStore (int nRounds, bool quantize = false, double tolerance = 0.0)
+    : mQuantize(quantize), mTolerance(tolerance), mRounds(nRounds, Round()), mMaxError(0.0), mPlainRounds(0)
+    { for (Round &r : mRounds) { r.rows = r.cols = 0; r.scale = 0.0; } }
+
+  int    number_of_rounds()          const { return (int) mRounds.size(); }
+  bool   has  (int round)            const { return mRounds[round].rows > 0; }
+
+  void   put  (int round, ValuePlanes const& planes);
+
+  Matrix mean (int round)            const;
+
+  long   bytes ()                    const;                // held by the stored rounds
+  double max_error ()                const { return mMaxError; }
+  int    plain_rounds ()             const { return mPlainRounds; }
+
+ private:
+  bool   encode (Matrix const& m, Round &r);               // false if error exceeds tolerance
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+  Throughput and accuracy of the precision of the values kept by the solvers.
+
+  Solves the configurations of the Makefile targets risk_check and reject_check
+  (constrained oracle, matrix solver) and the unconstrained risk configuration
+  noted there (vector solver) with values stored as float, mixed (float storage,
+  double interpolation) and double.  Reports the time per cell of a round and
+  how far the values at the last horizon are from those found with double.
+
+  Run with an argument to set the number of rounds (default 50).
+*/
+
+#include "bellman.Template.h"
+#include "wealth.Template.h"
+#include "utility.Template.h"
+
+#include <math.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+
+struct Run
+{
+  double       seconds;
+  HorizonValues last;
+};
+
+template <class F>
+Run
+measure (F const& f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<AngleSummary> summaries (f());
+  auto t1 = std::chrono::steady_clock::now();
+  Run run;
+  run.seconds = std::chrono::duration<double>(t1-t0).count();
+  run.last = summaries[0].horizons.back();
+  return run;
+}
+
+double
+max_difference (HorizonValues const& a, HorizonValues const& b)
+{
+  return std::max(fabs(a.utility-b.utility), std::max(fabs(a.row-b.row), fabs(a.col-b.col)));
+}
+
+//  solve(options) returns the summaries of a configuration; reports each precision against double
+template <class F>
+void
+compare (std::string label, double nCells, F const& solve)
+{
+  const SolverOptions::Precision precisions[3] = { SolverOptions::doubleValues, SolverOptions::mixedValues, SolverOptions::floatValues };
+  Run runs[3];
+  for (int i=0; i<3; ++i)
+  { SolverOptions options;
+    options.precision = precisions[i];
+    runs[i] = measure([&] () { return solve(options); });
+  }
+  for (int i=0; i<3; ++i)
+    std::cout << "BENCH: " << std::setw(14) << std::left << label << std::setw(7) << precision_name(precisions[i]) << std::right
+	      << std::setw(10) << std::setprecision(4) << 1.0e9*runs[i].seconds/nCells << " ns/cell"
+	      << std::setw(12) << std::setprecision(8) << runs[i].last.utility << std::setw(12) << runs[i].last.row << std::setw(12) << runs[i].last.col
+	      << "   max diff from double " << std::setprecision(3) << max_difference(runs[i].last, runs[0].last) << std::endl;
+}
+
+
+int  main(int argc, char** argv)
+{
+  const double maxWealth (10.0);
+  const int    nRounds = (argc > 1) ? atoi(argv[1]) : 50;
+  std::cout << "BENCH: " << nRounds << " rounds" << std::endl;
+
+  // risk_check: risk at 296.565, LS oracle and geometric bidder, both with omega 0.25
+  { UniversalRule univ;
+    GeometricRule geo (0.001);
+    DualWealthArray oracleWealth (univ.identifier(), maxWealth, 0.25, 0.25, univ, nRounds);
+    DualWealthArray bidderWealth (geo.identifier() , maxWealth, 0.25, 0.25, geo , nRounds);
+    std::vector<RiskMatrixUtility<AngleCriterion>> utilities (1, RiskMatrixUtility<AngleCriterion>(AngleCriterion(296.565)));
+    const double nCells ((double) nRounds * oracleWealth.number_wealth_positions() * bidderWealth.number_wealth_positions());
+    compare("risk_check", nCells, [&] (SolverOptions const& options)
+	    { return solve_bellman_matrix_utilities(nRounds, utilities, oracleWealth, bidderWealth, options); });
+  }
+
+  // reject_check: rejects at angle 0, LS oracle with omega 0.05 and geometric bidder with omega 0.5
+  { UniversalRule univ;
+    GeometricRule geo (0.10);
+    DualWealthArray oracleWealth (univ.identifier(), maxWealth, 0.05, 0.05, univ, nRounds);
+    DualWealthArray bidderWealth (geo.identifier() , maxWealth, 0.50, 0.50, geo , nRounds);
+    std::vector<RejectMatrixUtility<AngleCriterion>> utilities (1, RejectMatrixUtility<AngleCriterion>(AngleCriterion(0.0)));
+    const double nCells ((double) nRounds * oracleWealth.number_wealth_positions() * bidderWealth.number_wealth_positions());
+    compare("reject_check", nCells, [&] (SolverOptions const& options)
+	    { return solve_bellman_matrix_utilities(nRounds, utilities, oracleWealth, bidderWealth, options); });
+  }
+
+  // unconstrained risk inflation oracle against a geometric bidder with omega 0.5; at angle 0 as in
+  // the Makefile the col value does not enter the utility, so ties among means move it; use 10
+  { GeometricRule geo (0.10);
+    DualWealthArray bidderWealth (geo.identifier(), maxWealth, 0.50, 0.50, geo, nRounds);
+    RiskVectorUtility utility (10.0, 1.0);
+    std::vector<VectorUtility*> utilities (1, &utility);
+    const double nCells ((double) nRounds * bidderWealth.number_wealth_positions());
+    compare("unconstrained", nCells, [&] (SolverOptions const& options)
+	    { return solve_bellman_vector_utilities(nRounds, utilities, bidderWealth, false, options); });
+  }
+  return 0;
+}
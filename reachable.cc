@@ -0,0 +1,63 @@
+#include "reachable.h"
+
+//     ReachableStates     ReachableStates     ReachableStates     ReachableStates     ReachableStates
+
+namespace {
+  void
+  mark (std::pair<int,double> const& pos, int nPositions, std::vector<char> &reached)
+  {
+    if (0.0 < pos.second)                                            // weight on index
+      reached[pos.first] = 1;
+    if ((pos.second < 1.0) && (pos.first+1 < nPositions))            // rest on next higher index
+      reached[pos.first+1] = 1;
+  }
+}
+
+ReachableStates::ReachableStates (DualWealthArray const& wealth, int nRounds, bool cumulative)
+  : mPositions(wealth.number_wealth_positions()), mReached(nRounds, std::vector<char>(mPositions, 0)), mIndices(nRounds)
+{
+  if (nRounds == 0) return;
+  mReached[0][wealth.zero_index()] = 1;
+  for (int t=1; t<nRounds; ++t)
+  { std::vector<char> const& prior (mReached[t-1]);
+    std::vector<char>       &next  (mReached[t]);
+    if (cumulative) next = prior;
+    for (int k=0; k<mPositions; ++k)
+      if (prior[k])
+      { mark(wealth.bid_position(k),    mPositions, next);
+	mark(wealth.reject_position(k), mPositions, next);
+      }
+  }
+  for (int t=0; t<nRounds; ++t)
+    for (int k=0; k<mPositions; ++k)
+      if (mReached[t][k]) mIndices[t].push_back(k);
+}
+
+
+long
+ReachableStates::total_count () const
+{
+  long total (0);
+  for (std::vector<int> const& i : mIndices)
+    total += (long) i.size();
+  return total;
+}
+
+
+double
+fraction_skipped (ReachableStates const& states)
+{
+  const double cells ((double) states.number_of_rounds() * states.number_wealth_positions());
+  return (cells == 0.0) ? 0.0 : 1.0 - states.total_count() / cells;
+}
+
+
+double
+fraction_skipped (ReachableStates const& rowStates, ReachableStates const& colStates)
+{
+  double solved (0.0);
+  for (int t=0; t<rowStates.number_of_rounds(); ++t)
+    solved += (double) rowStates.count(t) * colStates.count(t);
+  const double cells ((double) rowStates.number_of_rounds() * rowStates.number_wealth_positions() * colStates.number_wealth_positions());
+  return (cells == 0.0) ? 0.0 : 1.0 - solved / cells;
+}
@@ -0,0 +1,62 @@
+#ifndef _REACHABLE_H_
+#define _REACHABLE_H_
+
+#include "wealth.h"
+
+#include <vector>
+
+/***********************************************************************************
+
+  Wealth positions reachable from the zero index of a dual wealth array.
+
+  A position moves to bid_position when the test does not reject and to
+  reject_position when it does.  Each is a randomized split between an index
+  and the next higher one; both halves with positive weight count as reached.
+  A forward pass from zero_index() marks the positions reached after t steps,
+  for t = 0,...,nRounds-1.  Round t of a backward solver (t rounds done, row t
+  of the vector solver) needs only these; the values it reads after one more
+  step are reached after t+1.
+
+  Cumulative sets hold the positions reached in at most t steps.  They cover
+  the zero index in every round, as needed to report the value of each shorter
+  horizon (--all-horizons).
+
+  For the matrix solver, a cell counts as reached if its row and its column
+  positions are.  The row and column take the same number of steps, and the
+  weights of the two-dimensional split are products of the row and column
+  shares, so this covers every cell reached (and perhaps a few more, since a
+  smaller bid cannot reject when the larger one does not).
+
+***********************************************************************************/
+
+class ReachableStates
+{
+  const int                         mPositions;
+  std::vector< std::vector<char> >  mReached;        // by round, then position
+  std::vector< std::vector<int> >   mIndices;        // positions reached, in order
+
+ public:
+
+  ReachableStates (DualWealthArray const& wealth, int nRounds, bool cumulative);
+
+  int  number_of_rounds()                const { return (int) mReached.size(); }
+  int  number_wealth_positions()         const { return mPositions; }
+
+  bool reached (int round, int k)        const { return mReached[round][k] != 0; }
+  int  count   (int round)               const { return (int) mIndices[round].size(); }
+
+  std::vector<int> const& indices (int round) const { return mIndices[round]; }
+
+  long total_count ()                    const;   // sum of counts over rounds
+};
+
+
+//  Share of the cells of a solver skipped over all rounds, for one or two wealth arrays
+
+double
+fraction_skipped (ReachableStates const& states);
+
+double
+fraction_skipped (ReachableStates const& rowStates, ReachableStates const& colStates);
+
+#endif
@@ -0,0 +1,109 @@
+#include "rejection_curves.h"
+
+#include <math.h>
+
+//     RejectionCurves     RejectionCurves     RejectionCurves     RejectionCurves     RejectionCurves
+
+RejectionCurves::RejectionCurves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth,
+				  std::pair<double,double> interval, double step)
+  : mGridSize(1 + (int) floor((interval.second - interval.first)/step + 1.0e-9)), mLo(interval.first), mStep(step),
+    mRowProb(), mRowRisk(), mColProb(), mColRisk()
+{
+  fill(rowWealth, mRowProb, mRowRisk);
+  fill(colWealth, mColProb, mColRisk);
+}
+
+
+void
+RejectionCurves::fill (DualWealthArray const& wealth, std::vector<double> &prob, std::vector<double> &risk) const
+{
+  const int n (1+mGridSize);
+  const int nPositions (wealth.number_wealth_positions());
+  prob.resize(nPositions*n);
+  risk.resize(nPositions*n);
+  std::vector<double> means (n);
+  for (int j=1; j<n; ++j)
+    means[j] = mean(j);
+  for (int k=0; k<nPositions; ++k)
+  { const double bid (wealth.bid(k));
+    const double z (z_alpha(bid/2));
+    prob[k*n] = bid;                                               // as in MatrixUtility at mu = 0
+    risk[k*n] = ::risk(0.0, bid);
+    reject_probs_and_risks(n-1, &means[1], &bid, &z, 0, &prob[k*n+1], &risk[k*n+1]);
+  }
+}
+
+
+//  Separate loops keep the inner loop to two streams when the risks carry no weight
+//  (rejection utility).
+
+std::pair<int,double>
+RejectionCurves::argmax (CurveWeights const& w, int r, int c) const
+{
+  const int n (1+mGridSize);
+  double const* ra (&mRowProb[r*n]);
+  double const* rb (&mColProb[c*n]);
+  double const* ka (&mRowRisk[r*n]);
+  double const* kb (&mColRisk[c*n]);
+  int    best (1);
+  double bestValue (-INFINITY);
+  if ((0.0 == w.riskAlpha) && (0.0 == w.riskBeta))
+  { for (int j=1; j<n; ++j)
+    { const double u (w.probAlpha*ra[j] + w.probBeta*rb[j]);
+      if (u > bestValue) { bestValue = u; best = j; }
+    }
+  }
+  else
+  { for (int j=1; j<n; ++j)
+    { const double u (w.probAlpha*ra[j] + w.probBeta*rb[j] + w.riskAlpha*ka[j] + w.riskBeta*kb[j]);
+      if (u > bestValue) { bestValue = u; best = j; }
+    }
+  }
+  return std::make_pair(best, w.constant + bestValue);
+}
+
+
+//     RejectionBounds     RejectionBounds     RejectionBounds     RejectionBounds     RejectionBounds
+
+RejectionBounds::RejectionBounds (std::vector<double> const& levels, std::pair<double,double> interval, int nPieces)
+  : mPieces(nPieces), mProbLo(levels.size()*nPieces), mProbHi(levels.size()*nPieces),
+    mRiskLo(levels.size()*nPieces), mRiskHi(levels.size()*nPieces)
+{
+  std::vector<double> ends (piece_ends(interval, nPieces));
+  for (int i=0; i<(int)levels.size(); ++i)
+  { const double level (levels[i]);
+    for (int p=0; p<nPieces; ++p)
+    { const double a (ends[p]), b (ends[p+1]);
+      const int k (i*nPieces+p);
+      mProbLo[k] = reject_prob(a, level);
+      mProbHi[k] = reject_prob(b, level);
+      std::pair<double,double> rb (risk_bounds(a, b, level));
+      mRiskLo[k] = rb.first;
+      mRiskHi[k] = rb.second;
+    }
+  }
+}
+
+
+//  When mu=0 is optimal, the utility at the start of the interval is only a little less than
+//  at mu=0, so the pieces must be short there for the bound to show it; they grow
+//  geometrically (by the same factor) toward the end of the interval.
+
+std::vector<double>
+RejectionBounds::piece_ends (std::pair<double,double> interval, int nPieces)
+{
+  const double firstWidth (0.005);
+  double lo (1.0), hi (2.0);                                        // bisect for growth factor
+  while (firstWidth * (pow(hi,nPieces)-1)/(hi-1) < interval.second - interval.first) hi *= 2;
+  for (int it=0; it<60; ++it)
+  { const double g (0.5*(lo+hi));
+    if (firstWidth * (pow(g,nPieces)-1)/(g-1) < interval.second - interval.first) lo = g; else hi = g;
+  }
+  std::vector<double> ends (nPieces+1);
+  double width (firstWidth);
+  ends[0] = interval.first;
+  for (int p=1; p<nPieces; ++p, width *= hi)
+    ends[p] = ends[p-1] + width;
+  ends[nPieces] = interval.second;
+  return ends;
+}
@@ -0,0 +1,117 @@
+#ifndef _REJECTION_CURVES_H_
+#define _REJECTION_CURVES_H_
+
+#include "utility.h"     // CurveWeights
+#include "wealth.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <math.h>
+
+/***********************************************************************************
+
+  Tables of the rejection probability and risk curves of the bids in a pair of
+  dual wealth arrays (rows, columns).
+
+  The bid at a wealth position does not change from round to round, so neither
+  do reject_prob(mu,bid) and risk(mu,bid) as functions of mu.  The tables hold
+  them at mu = 0 (index 0) and on a fine grid over the search interval
+  (indices 1..n), one row of the table for each wealth position.  Maximizing
+  a matrix utility over the grid then needs only its CurveWeights: a linear
+  combination of four table rows and an argmax, with no calls to normal_cdf or
+  normal_quantile.
+
+***********************************************************************************/
+
+class RejectionCurves
+{
+  const int    mGridSize;                                  // grid means, not counting mu = 0
+  const double mLo, mStep;
+  std::vector<double> mRowProb, mRowRisk, mColProb, mColRisk;   // by wealth position, then mean
+
+ public:
+
+  RejectionCurves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth,
+		   std::pair<double,double> interval, double step);
+
+  int    grid_size()               const { return mGridSize; }
+  double grid_step()               const { return mStep; }
+  double mean (int j)              const { return (0 == j) ? 0.0 : mLo + (j-1)*mStep; }
+
+  // value of weighted curves for row r and col c at mean index j
+  double value (CurveWeights const& w, int r, int c, int j) const;
+
+  // index of grid mean (1..n) maximizing the weighted curves, and the maximum
+  std::pair<int,double> argmax (CurveWeights const& w, int r, int c) const;
+
+ private:
+  void   fill (DualWealthArray const& wealth, std::vector<double> &prob, std::vector<double> &risk) const;
+};
+
+
+inline
+double
+RejectionCurves::value (CurveWeights const& w, int r, int c, int j) const
+{
+  const int n (1+mGridSize);
+  return w(mRowProb[r*n+j], mColProb[c*n+j], mRowRisk[r*n+j], mColRisk[c*n+j]);
+}
+
+
+
+/***********************************************************************************
+
+  Bounds on the same curves over pieces of the search interval, for a list of
+  levels (the bids at the wealth positions, or a fixed oracle level).
+
+  The pieces are short near the start of the interval and grow toward its end.
+  The rejection probability increases in mu > 0, so on a piece [a,b] it lies
+  between its values at a and b; risk_bounds gives the bounds for the risk.
+  The upper bound of a utility with given CurveWeights is the largest over the
+  pieces of its weighted bounds, taking the upper bound of a curve with a
+  positive weight and the lower bound otherwise.  If that is less than the
+  utility at mu = 0, the search over the interval cannot beat mu = 0.
+
+***********************************************************************************/
+
+class RejectionBounds
+{
+  const int mPieces;
+  std::vector<double> mProbLo, mProbHi, mRiskLo, mRiskHi;      // by level, then piece
+
+ public:
+
+  RejectionBounds (std::vector<double> const& levels, std::pair<double,double> interval, int nPieces);
+
+  // bound for weights w, with alpha the level at index i and beta the level at index j of other
+  double upper_bound (CurveWeights const& w, int i, RejectionBounds const& other, int j) const;
+
+ private:
+  static std::vector<double> piece_ends (std::pair<double,double> interval, int nPieces);
+};
+
+
+inline
+double
+bound_term (double weight, double lo, double hi)
+{
+  return (0.0 < weight) ? weight * hi : weight * lo;
+}
+
+inline
+double
+RejectionBounds::upper_bound (CurveWeights const& w, int i, RejectionBounds const& other, int j) const
+{
+  double const* paLo (&mProbLo[i*mPieces]);        double const* paHi (&mProbHi[i*mPieces]);
+  double const* kaLo (&mRiskLo[i*mPieces]);        double const* kaHi (&mRiskHi[i*mPieces]);
+  double const* pbLo (&other.mProbLo[j*mPieces]);  double const* pbHi (&other.mProbHi[j*mPieces]);
+  double const* kbLo (&other.mRiskLo[j*mPieces]);  double const* kbHi (&other.mRiskHi[j*mPieces]);
+  double bound (-INFINITY);
+  for (int p=0; p<mPieces; ++p)
+    bound = std::max(bound, bound_term(w.probAlpha, paLo[p], paHi[p]) + bound_term(w.probBeta, pbLo[p], pbHi[p])
+		     + bound_term(w.riskAlpha, kaLo[p], kaHi[p]) + bound_term(w.riskBeta, kbLo[p], kbHi[p]));
+  return w.constant + bound;
+}
+
+#endif
@@ -0,0 +1,505 @@
+#include "solve_server.h"
+
+#include "checkpoint.h"             // checkpoint_key
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+const std::string serverTag = "SERV: ";
+
+typedef std::chrono::steady_clock Clock;
+
+//     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs     Jobs
+
+struct ServeConnection
+{
+  const int          outFd;
+  std::mutex         writeMutex;
+  bool               broken;                               // a write failed; the client is gone
+  std::map<std::string, std::shared_ptr<ServeJob>> jobs;   // queued or running, by id (under the mutex of the server)
+
+  explicit ServeConnection (int fd) : outFd(fd), writeMutex(), broken(false), jobs() { }
+
+  void write (std::string const& lines);
+};
+
+
+struct ServeJob
+{
+  const std::string                      id;
+  const SolveSpec                        spec;
+  const std::shared_ptr<ServeConnection> connection;
+  const Clock::time_point                received;
+  std::atomic<bool>                      cancel;
+
+  ServeJob (std::string const& i, SolveSpec const& s, std::shared_ptr<ServeConnection> const& c)
+    : id(i), spec(s), connection(c), received(Clock::now()), cancel(false) { }
+};
+
+
+void
+ServeConnection::write (std::string const& lines)
+{
+  std::lock_guard<std::mutex> lock (writeMutex);
+  char const* p (lines.data());
+  size_t left (lines.size());
+  while (!broken && (0 < left))
+  { const ssize_t n (::write(outFd, p, left));
+    if (n < 0)
+    { if (errno == EINTR) continue;
+      broken = true;
+    }
+    else
+    { p += n; left -= n; }
+  }
+}
+
+
+namespace {
+
+  double
+  milliseconds (Clock::time_point from, Clock::time_point to)
+  {
+    return 1000.0 * std::chrono::duration<double>(to - from).count();
+  }
+
+  std::vector<std::string>
+  split (std::string const& line)
+  {
+    std::vector<std::string> words;
+    std::istringstream input (line.substr(0, line.find('#')));
+    std::string word;
+    while (input >> word)
+      words.push_back(word);
+    return words;
+  }
+
+  bool
+  hung_up (int fd)                                         // the reader of fd closed it (not just its own side)
+  {
+    pollfd p = { fd, 0, 0 };
+    return (0 < poll(&p, 1, 0)) && (p.revents & (POLLHUP | POLLERR));
+  }
+
+  bool
+  read_line (int fd, std::string &buffer, std::string *line)
+  {
+    while (true)
+    { const size_t end (buffer.find('\n'));
+      if (end != std::string::npos)
+      { *line = buffer.substr(0, end);
+	buffer.erase(0, end+1);
+	return true;
+      }
+      char chunk[4096];
+      const ssize_t n (::read(fd, chunk, sizeof(chunk)));
+      if ((n < 0) && (errno == EINTR)) continue;
+      if (n <= 0)                                          // end of input; a last line lacking its newline
+      { *line = buffer;
+	buffer.clear();
+	return !line->empty();
+      }
+      buffer.append(chunk, n);
+    }
+  }
+
+  std::string
+  number_key (double x)
+  {
+    std::ostringstream ss;
+    ss << std::setprecision(17) << x;
+    return ss.str();
+  }
+
+  // Stencils and tables from the caches of the server, counting those found for a job
+  class JobTables : public TableSource
+  {
+    LruCache<TransitionStencil> &mStencils;
+    LruCache<RejectionCurves>   &mCurves;
+
+  public:
+    int hits, requests;
+
+    JobTables (LruCache<TransitionStencil> &stencils, LruCache<RejectionCurves> &curves)
+      : mStencils(stencils), mCurves(curves), hits(0), requests(0) { }
+
+    std::shared_ptr<const TransitionStencil>
+    stencil (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, int valueBytes)
+    { bool hit;
+      std::shared_ptr<const TransitionStencil> s (mStencils.find_or_make(checkpoint_key("stencil " + std::to_string(valueBytes), rowWealth, colWealth),
+					[&] () { return new TransitionStencil(rowWealth, colWealth, 0, valueBytes); }, &hit));
+      count(hit);
+      return s;
+    }
+
+    std::shared_ptr<const RejectionCurves>
+    rejection_curves (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, SolverOptions const& options)
+    { bool hit;
+      std::shared_ptr<const RejectionCurves> c (mCurves.find_or_make(checkpoint_key("curves " + number_key(options.tableStep), rowWealth, colWealth),
+					[&] () { return make_rejection_curves(rowWealth, colWealth, options); }, &hit));
+      count(hit);
+      return c;
+    }
+
+  private:
+    void count (bool hit) { ++requests; if (hit) ++hits; }
+  };
+
+  bool
+  parse_number (std::string const& text, double *x)
+  {
+    char *end;
+    *x = strtod(text.c_str(), &end);
+    return !text.empty() && (0 == *end);
+  }
+
+}
+
+
+bool
+parse_job_options (std::vector<std::string> const& words, SolveSpec *spec, std::string *error)
+{
+  SolveSpec s;
+  s.oracle = PlayerSpec { -1, -1, -1 };                    // negative if not set, as in bellman
+  s.bidder = PlayerSpec { -1, -1, -1 };
+  for (size_t i=0; i<words.size(); ++i)
+  { const std::string name ((0 == words[i].compare(0, 2, "--")) ? words[i].substr(2) : "");
+    if      (name == "risk")         s.risk = true;
+    else if (name == "reject")       s.risk = false;
+    else if (name == "warm-start")   s.options.warmStart = true;
+    else if (name == "monotone")     s.options.monotone = true;
+    else if (name == "refine")       s.options.refineTable = true;
+    else if (name == "newton")       s.options.newton = true;
+    else if (name == "lockstep")     s.options.lockstep = true;
+    else if (name == "prune")        s.options.prune = true;
+    else if (name == "all-horizons") s.options.allHorizons = true;
+    else if (name == "reachable")    s.options.reachable = true;
+    else if (name == "accelerate")   s.options.accelerate = true;
+    else if ((name == "angle") || (name == "oracle_w0") || (name == "oracle_prob") || (name == "oracle_omega") || (name == "bidder_w0")
+	     || (name == "bidder_prob") || (name == "bidder_omega") || (name == "rounds") || (name == "threads") || (name == "table")
+	     || (name == "stationary") || (name == "precision") || (name == "scale"))
+    { if (words.size() == i+1)
+      { *error = "option --" + name + " needs a value";
+	return false;
+      }
+      const std::string value (words[++i]);
+      double x (0.0);
+      if (name == "precision")
+      { if (!parse_precision(value, &s.options.precision))
+	{ *error = "precision " + value + " is not float, mixed or double";
+	  return false;
+	}
+	continue;
+      }
+      if (name == "scale")                                 // no longer used by bellman either
+	continue;
+      if (name == "angle")
+      { s.angles.clear();
+	std::istringstream input (value);
+	std::string item;
+	bool numbers (true);
+	while (std::getline(input, item, ','))
+	  if (parse_number(item, &x))
+	    s.angles.push_back(x);
+	  else
+	    numbers = numbers && item.empty();
+	if (s.angles.empty() || !numbers)
+	{ *error = "angles " + value + " are not a list of numbers";
+	  return false;
+	}
+	continue;
+      }
+      if (!parse_number(value, &x))
+      { *error = "value " + value + " of --" + name + " is not a number";
+	return false;
+      }
+      if      (name == "oracle_w0")    s.oracle.W0 = x;
+      else if (name == "oracle_prob")  s.oracle.prob = x;
+      else if (name == "oracle_omega") s.oracle.omega = x;
+      else if (name == "bidder_w0")    s.bidder.W0 = x;
+      else if (name == "bidder_prob")  s.bidder.prob = x;
+      else if (name == "bidder_omega") s.bidder.omega = x;
+      else if (name == "rounds")       s.nRounds = (int) x;
+      else if (name == "threads")      s.options.nThreads = (int) x;
+      else if (name == "table")        s.options.tableStep = x;
+      else if (name == "stationary")   s.options.stationaryTol = x;
+    }
+    else
+    { *error = "option " + words[i] + " is not available to jobs";
+      return false;
+    }
+  }
+  if ((s.oracle.prob < 0) || (s.oracle.omega < 0) || (s.bidder.prob < 0) || (s.bidder.omega < 0))
+  { *error = "a job needs --oracle_prob, --oracle_omega, --bidder_prob and --bidder_omega";
+    return false;
+  }
+  if ((s.nRounds < 1) || (s.options.nThreads < 1))
+  { *error = "rounds and threads must be positive";
+    return false;
+  }
+  if (s.oracle.W0 < 0) s.oracle.W0 = s.oracle.omega;       // W0 is omega unless given
+  if (s.bidder.W0 < 0) s.bidder.W0 = s.bidder.omega;
+  *spec = s;
+  return true;
+}
+
+
+//     SolveServer     SolveServer     SolveServer     SolveServer     SolveServer     SolveServer     SolveServer
+
+SolveServer::SolveServer (int nWorkers, int cacheSize)
+  : mWorkers(nWorkers < 1 ? 1 : nWorkers), mWealth(2*cacheSize), mStencils(cacheSize), mCurves(cacheSize),
+    mQueue(), mMutex(), mChanged(), mFinishing(false), mRunning(0), mConnections(0),
+    mDone(0), mCancelled(0), mFailed(0), mThreads()
+{
+  std::clog << serverTag << "Solving jobs on " << mWorkers << " worker threads; caches hold " << 2*cacheSize
+	    << " wealth arrays, " << cacheSize << " stencils and " << cacheSize << " tables of rejection curves" << std::endl;
+  for (int i=0; i<mWorkers; ++i)
+    mThreads.push_back(std::thread(&SolveServer::run, this));
+}
+
+
+void
+SolveServer::finish ()
+{
+  { std::lock_guard<std::mutex> guard (mMutex);
+    if (mFinishing) return;
+    mFinishing = true;
+  }
+  mChanged.notify_all();
+  for (std::thread &t : mThreads)
+    t.join();
+  std::clog << serverTag << "Finished " << mDone << " jobs (" << mCancelled << " cancelled, " << mFailed << " failed)" << std::endl;
+}
+
+
+void
+SolveServer::run ()
+{
+  std::unique_lock<std::mutex> lock (mMutex);
+  while (true)
+  { mChanged.wait(lock, [this] () { return mFinishing || !mQueue.empty(); });
+    if (mQueue.empty()) return;                            // finishing
+    std::shared_ptr<ServeJob> job (mQueue.front());
+    mQueue.pop_front();
+    ++mRunning;
+    lock.unlock();
+    solve(*job);
+    lock.lock();
+    --mRunning;
+    job->connection->jobs.erase(job->id);
+    mChanged.notify_all();                                 // the connection may be waiting for its last job
+  }
+}
+
+
+std::shared_ptr<const DualWealthArray>
+SolveServer::wealth (PlayerSpec const& player, int nRounds, bool *hit)
+{
+  const std::string key (number_key(player.W0) + " " + number_key(player.prob) + " " + number_key(player.omega) + " " + std::to_string(nRounds));
+  return mWealth.find_or_make(key, [&] () { return make_player_wealth(player, nRounds); }, hit);
+}
+
+
+void
+SolveServer::solve (ServeJob &job)
+{
+  const Clock::time_point start (Clock::now());
+  std::ostringstream out;
+  out << std::setprecision(6);
+  if (job.cancel)
+  { out << "cancelled " << job.id << " wait_ms=" << milliseconds(job.received, start) << " solve_ms=0\n";
+    job.connection->write(out.str());
+    std::lock_guard<std::mutex> guard (mMutex);
+    ++mDone; ++mCancelled;
+    return;
+  }
+  bool failed (false), cancel (false);
+  try
+  { bool hit;
+    int wealthHits (0), wealthUsed (0);
+    std::shared_ptr<const DualWealthArray> bidder (wealth(job.spec.bidder, job.spec.nRounds, &hit));
+    ++wealthUsed; wealthHits += hit;
+    std::shared_ptr<const DualWealthArray> oracle;
+    if (!job.spec.oracle.unconstrained())
+    { oracle = wealth(job.spec.oracle, job.spec.nRounds, &hit);
+      ++wealthUsed; wealthHits += hit;
+    }
+    const Clock::time_point built (Clock::now());
+    JobTables tables (mStencils, mCurves);
+    SolveSpec spec (job.spec);
+    spec.options.tables = &tables;
+    spec.options.cancel = &job.cancel;
+    const std::vector<AngleSummary> summaries (SolverContext(spec, bidder, oracle).solve());
+    const Clock::time_point solved (Clock::now());
+    cancel = job.cancel;
+    if (cancel)
+      out << "cancelled " << job.id << " wait_ms=" << milliseconds(job.received, start) << " solve_ms=" << milliseconds(built, solved) << "\n";
+    else
+    { for (AngleSummary const& summary : summaries)
+      { std::ostringstream lines;
+	write_horizons(lines, summary.config, summary.horizons, spec.options.allHorizons);
+	std::istringstream input (lines.str());
+	std::string line;
+	while (std::getline(input, line))
+	  out << "result " << job.id << " " << line << "\n";
+      }
+      out << "done " << job.id << " wait_ms=" << milliseconds(job.received, start) << " wealth_ms=" << milliseconds(start, built)
+	  << " solve_ms=" << milliseconds(built, solved) << " wealth_hits=" << wealthHits << "/" << wealthUsed
+	  << " table_hits=" << tables.hits << "/" << tables.requests << "\n";
+    }
+  }
+  catch (std::exception const& e)
+  { failed = true;
+    out.str("");
+    out << "error " << job.id << " " << e.what() << "\n";
+  }
+  job.connection->write(out.str());
+  std::lock_guard<std::mutex> guard (mMutex);
+  ++mDone;
+  if (cancel) ++mCancelled;
+  if (failed) ++mFailed;
+}
+
+
+std::string
+SolveServer::stats ()
+{
+  std::ostringstream out;
+  { std::lock_guard<std::mutex> guard (mMutex);
+    out << "stats - workers=" << mWorkers << " queued=" << mQueue.size() << " running=" << mRunning
+	<< " done=" << mDone << " cancelled=" << mCancelled << " failed=" << mFailed;
+  }
+  out << " wealth=" << mWealth.size() << "/" << mWealth.capacity() << "," << mWealth.hits() << "," << mWealth.misses()
+      << " stencils=" << mStencils.size() << "/" << mStencils.capacity() << "," << mStencils.hits() << "," << mStencils.misses()
+      << " curves=" << mCurves.size() << "/" << mCurves.capacity() << "," << mCurves.hits() << "," << mCurves.misses() << "\n";
+  return out.str();
+}
+
+
+bool
+SolveServer::handle (std::string const& line, std::shared_ptr<ServeConnection> const& connection)
+{
+  const std::vector<std::string> words (split(line));
+  if (words.empty())
+    return true;
+  const std::string command (words[0]);
+  const std::string id ((1 < words.size()) ? words[1] : "-");
+  if (command == "quit")
+    return false;
+  if (command == "stats")
+    connection->write(stats());
+  else if ((command == "solve") && (1 < words.size()))
+  { SolveSpec spec;
+    std::string error;
+    if (!parse_job_options(std::vector<std::string>(words.begin()+2, words.end()), &spec, &error))
+    { connection->write("error " + id + " " + error + "\n");
+      return true;
+    }
+    std::shared_ptr<ServeJob> job (new ServeJob(id, spec, connection));
+    size_t ahead (0);
+    { std::lock_guard<std::mutex> guard (mMutex);
+      if (connection->jobs.count(id))
+	ahead = std::string::npos;
+      else
+      { connection->jobs[id] = job;
+	ahead = mQueue.size();
+	mQueue.push_back(job);
+      }
+    }
+    if (ahead == std::string::npos)
+      connection->write("error " + id + " job " + id + " is still queued or running\n");
+    else
+    { connection->write("queued " + id + " ahead=" + std::to_string(ahead) + "\n");
+      mChanged.notify_all();
+    }
+  }
+  else if ((command == "cancel") && (1 < words.size()))
+  { bool found (false);
+    { std::lock_guard<std::mutex> guard (mMutex);
+      auto it = connection->jobs.find(id);
+      if (it != connection->jobs.end())
+      { it->second->cancel = true;
+	found = true;
+      }
+    }
+    if (!found)
+      connection->write("error " + id + " no job " + id + " is queued or running\n");
+  }
+  else
+    connection->write("error " + id + " request " + command + " is not solve ID, cancel ID, stats or quit\n");
+  return true;
+}
+
+
+void
+SolveServer::serve_stream (int inFd, int outFd)
+{
+  std::shared_ptr<ServeConnection> connection (new ServeConnection(outFd));
+  std::string buffer, line;
+  while (read_line(inFd, buffer, &line) && handle(line, connection))
+    if (connection->broken) break;
+  std::unique_lock<std::mutex> lock (mMutex);
+  bool gone (connection->broken);
+  while (!connection->jobs.empty())
+  { if (gone || (gone = hung_up(outFd)))                   // no one to read the results
+      for (auto const& job : connection->jobs)
+	job.second->cancel = true;
+    mChanged.wait_for(lock, std::chrono::milliseconds(250));
+  }
+}
+
+
+bool
+SolveServer::serve_socket (std::string const& path)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (sizeof(address.sun_path) <= path.size())
+  { std::clog << serverTag << "Socket path " << path << " is too long" << std::endl;
+    return false;
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path)-1);
+  const int fd (socket(AF_UNIX, SOCK_STREAM, 0));
+  unlink(path.c_str());                                    // left by a server that was killed
+  if ((fd < 0) || (bind(fd, (sockaddr*) &address, sizeof(address)) < 0) || (listen(fd, 16) < 0))
+  { std::clog << serverTag << "Cannot listen on " << path << ": " << strerror(errno) << std::endl;
+    if (0 <= fd) close(fd);
+    return false;
+  }
+  std::clog << serverTag << "Listening on " << path << std::endl;
+  while (true)
+  { const int client (accept(fd, 0, 0));
+    if (client < 0)
+    { if (errno == EINTR) continue;
+      std::clog << serverTag << "Stopped accepting clients: " << strerror(errno) << std::endl;
+      break;
+    }
+    { std::lock_guard<std::mutex> guard (mMutex);
+      ++mConnections;
+    }
+    std::thread([this, client] ()
+		{ serve_stream(client, client);
+		  close(client);
+		  std::lock_guard<std::mutex> guard (mMutex);
+		  --mConnections;
+		  mChanged.notify_all();
+		}).detach();
+  }
+  close(fd);
+  std::unique_lock<std::mutex> lock (mMutex);
+  mChanged.wait(lock, [this] () { return 0 == mConnections; });
+  return true;
+}
@@ -0,0 +1,101 @@
+#ifndef _SOLVE_SERVER_H_
+#define _SOLVE_SERVER_H_
+
+#include "solver_context.h"
+#include "lru_cache.h"
+#include "stencil.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************************************
+
+  Long-running solver (bellman serve) taking jobs as lines of text from its
+  input, or from each client of a UNIX domain socket, and writing the results
+  back as lines.
+
+  A pool of worker threads solves the jobs in the order received.  Jobs share
+  caches of the wealth arrays of the players and of the stencils and tables of
+  rejection curves of the matrix solver, each dropping the least recently used
+  once full, so that a job like one solved recently skips building them.
+  Stencils and tables are keyed by the contents of the wealth arrays.
+
+  Requests, one per line (words separated by blanks; # starts a comment):
+      solve ID OPTIONS      solve as bellman would with these options, as in
+                            solve a1 --risk --angle 296.565 --rounds 200 --oracle_prob 0
+                                     --oracle_omega 0.25 --bidder_prob 0.001 --bidder_omega 0.25
+                            (--scale is accepted and ignored, as bellman no longer uses it)
+      cancel ID             stop job ID, queued or running (after its current round)
+      stats                 counts of jobs and of the use of the caches
+      quit                  stop reading; as the end of input
+  Responses, one per line, each starting with its kind and the job id:
+      queued ID ahead=K
+      result ID LINE        a summary line of bellman (one per angle, or per horizon with --all-horizons)
+      done ID wait_ms=W wealth_ms=B solve_ms=S wealth_hits=H/N table_hits=H/N
+      cancelled ID wait_ms=W solve_ms=S
+      error ID MESSAGE
+  Results of different jobs may interleave, but the lines of a job come
+  together.  Jobs do not write path details, checkpoints or frontiers, and
+  the accuracy of the normal functions is that the server was started with.
+  At the end of its input (a client may close just its side for writing), the
+  jobs of a client finish before the server lets it go; a client that closes
+  the connection, or the reader of stdout, cancels them.  Solver messages go
+  to clog as usual.
+
+***********************************************************************************/
+
+struct ServeJob;
+struct ServeConnection;
+
+class SolveServer
+{
+  const int                              mWorkers;
+  LruCache<DualWealthArray>              mWealth;
+  LruCache<TransitionStencil>            mStencils;
+  LruCache<RejectionCurves>              mCurves;
+  std::deque<std::shared_ptr<ServeJob>>  mQueue;
+  std::mutex                             mMutex;
+  std::condition_variable                mChanged;         // job queued, connection closed, or finishing
+  bool                                   mFinishing;
+  int                                    mRunning, mConnections;
+  long                                   mDone, mCancelled, mFailed;
+  std::vector<std::thread>               mThreads;
+
+ public:
+
+  SolveServer (int nWorkers, int cacheSize);
+  ~SolveServer() { finish(); }
+
+  SolveServer (SolveServer const&) = delete;
+  SolveServer& operator=(SolveServer const&) = delete;
+
+  // reads requests from inFd and writes responses to outFd until the end of input or quit,
+  // then waits for the jobs read to finish
+  void   serve_stream (int inFd, int outFd);
+
+  // serves each client of a socket at path (replacing a stale one) as a stream; false if cannot listen
+  bool   serve_socket (std::string const& path);
+
+  void   finish ();                                        // stops the workers once the queue is empty
+
+ private:
+  void   run ();
+  void   solve (ServeJob &job);
+  bool   handle (std::string const& line, std::shared_ptr<ServeConnection> const& connection);
+  std::string stats ();
+  std::shared_ptr<const DualWealthArray> wealth (PlayerSpec const& player, int nRounds, bool *hit);
+};
+
+
+//  Spec of a job from the words of a solve request after its id, which are options of bellman;
+//  false with a message if an option is not known, lacks its value, or is not available to jobs
+
+bool
+parse_job_options (std::vector<std::string> const& words, SolveSpec *spec, std::string *error);
+
+#endif
@@ -0,0 +1,69 @@
+#include "solver_context.h"
+
+#include "bellman.Template.h"
+#include "wealth.Template.h"
+#include "utility.Template.h"
+
+//     SolverContext     SolverContext     SolverContext     SolverContext     SolverContext     SolverContext
+
+SolverContext::SolverContext (SolveSpec const& spec)
+  : mSpec(spec), mBidderWealth(make_player_wealth(spec.bidder, spec.nRounds)),
+    mOracleWealth(spec.oracle.unconstrained() ? 0 : make_player_wealth(spec.oracle, spec.nRounds)) { }
+
+
+std::vector<AngleSummary>
+SolverContext::solve (std::vector<MeanPolicy> *policies) const
+{
+  return solve_angles(mSpec.angles, mSpec.risk, mSpec.oracle.prob, mSpec.nRounds, mOracleWealth.get(), *mBidderWealth,
+		      false, mSpec.options, policies);
+}
+
+
+//     Solves     Solves     Solves     Solves     Solves     Solves     Solves     Solves     Solves     Solves
+
+DualWealthArray*
+make_player_wealth (PlayerSpec const& player, int nRounds, double maxWealth)
+{
+  if (player.unconstrained())                            // fixed wealth testimator
+    return new DualWealthArray(player.W0);
+  else if (0 == player.prob)                             // universal
+  { UniversalRule rule;
+    return new DualWealthArray(rule.identifier(), maxWealth, player.W0, player.omega, rule, nRounds);
+  }
+  else                                                   // geometric
+  { GeometricRule rule (player.prob);
+    return new DualWealthArray(rule.identifier(), maxWealth, player.W0, player.omega, rule, nRounds);
+  }
+}
+
+
+std::vector<AngleSummary>
+solve_angles (std::vector<double> const& angles, bool riskUtil, double oracleAlpha, int nRounds,
+	      DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, bool writeDetails,
+	      SolverOptions const& options, std::vector<MeanPolicy> *policies)
+{
+  if (!pOracleWealth)                // unconstrained
+  { std::vector<std::unique_ptr<VectorUtility>> utilities;
+    for (double angle : angles)
+      if (riskUtil)
+	utilities.emplace_back(make_risk_vector_utility(angle, oracleAlpha));
+      else
+	utilities.emplace_back(new RejectVectorUtility(angle, oracleAlpha));
+    std::vector<VectorUtility*> pUtilities;
+    for (std::unique_ptr<VectorUtility> const& u : utilities)
+      pUtilities.push_back(u.get());
+    return solve_bellman_vector_utilities (nRounds, pUtilities, bidderWealth, writeDetails, options, policies);
+  }
+  if (riskUtil)
+  { std::vector<RiskMatrixUtility<AngleCriterion>> utilities;
+    for (double angle : angles)
+      utilities.push_back(RiskMatrixUtility<AngleCriterion>(AngleCriterion(angle)));
+    return solve_bellman_matrix_utilities (nRounds, utilities, *pOracleWealth, bidderWealth, options, policies);
+  }
+  else
+  { std::vector<RejectMatrixUtility<AngleCriterion>> utilities;
+    for (double angle : angles)
+      utilities.push_back(RejectMatrixUtility<AngleCriterion>(AngleCriterion(angle)));
+    return solve_bellman_matrix_utilities (nRounds, utilities, *pOracleWealth, bidderWealth, options, policies);
+  }
+}
@@ -0,0 +1,94 @@
+#ifndef _SOLVER_CONTEXT_H_
+#define _SOLVER_CONTEXT_H_
+
+#include "bellman.h"
+#include "wealth.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/***********************************************************************************
+
+  Solves driven from a program rather than from the command line (libbellman.a).
+
+  A SolveSpec describes a configuration as the options of bellman do: the
+  utility (risk or rejections) at one or more angles, the oracle and the bidder
+  (initial wealth, probability, omega), the number of rounds and the options
+  of the solver.  A SolverContext built from a spec holds the wealth arrays of
+  the players (its own, or ones shared with other contexts, which only read
+  them) and solves the spec, returning the values by horizon of each angle
+  rather than writing them.  The space needed by a solve (value planes, search
+  state) belongs to that solve and is released when it returns.
+
+  Contexts share no mutable state, so N threads can each solve their own
+  context at once (each solve may use options.nThreads threads of its own).
+  Solves through a context do not write path details.  The accuracy of the
+  normal functions (Special::set_accuracy) is a setting of the process: make
+  it before starting solves.
+
+***********************************************************************************/
+
+//  A player as in the options: W0, probability (oracle alpha: 0 least squares, 1 risk inflation,
+//  else testimator; bidder: 0 universal, else geometric rate) and omega (1 unconstrained)
+
+struct PlayerSpec
+{
+  double W0, prob, omega;
+
+  bool unconstrained() const { return 1 == omega; }
+};
+
+
+struct SolveSpec
+{
+  bool                risk;                                // risk, else rejections
+  std::vector<double> angles;                              // degrees, solved in one sweep
+  PlayerSpec          oracle, bidder;
+  int                 nRounds;
+  SolverOptions       options;
+
+  SolveSpec() : risk(false), angles(1, 0.0), oracle(), bidder(), nRounds(100), options() { }
+};
+
+
+class SolverContext
+{
+  const SolveSpec                         mSpec;
+  std::shared_ptr<const DualWealthArray>  mBidderWealth;
+  std::shared_ptr<const DualWealthArray>  mOracleWealth;   // null for an unconstrained oracle
+
+ public:
+
+  explicit SolverContext (SolveSpec const& spec);
+
+  // wealth arrays built before for the players of the spec (as by make_player_wealth), shared with others
+  SolverContext (SolveSpec const& spec, std::shared_ptr<const DualWealthArray> bidderWealth, std::shared_ptr<const DualWealthArray> oracleWealth)
+    : mSpec(spec), mBidderWealth(bidderWealth), mOracleWealth(oracleWealth) { }
+
+  SolverContext (SolverContext const&) = delete;
+  SolverContext& operator=(SolverContext const&) = delete;
+
+  SolveSpec       const& spec()          const { return mSpec; }
+  DualWealthArray const& bidder_wealth() const { return *mBidderWealth; }
+  DualWealthArray const* oracle_wealth() const { return mOracleWealth.get(); }
+
+  // values at each horizon for each angle, in the order of the angles
+  std::vector<AngleSummary> solve (std::vector<MeanPolicy> *policies = 0) const;
+};
+
+
+//  Wealth array of a player for a solve of nRounds (fixed wealth W0 if unconstrained)
+
+DualWealthArray*
+make_player_wealth (PlayerSpec const& player, int nRounds, double maxWealth = 10.0);
+
+
+//  Solves the angles in one sweep; the oracle wealth is null for an unconstrained oracle
+
+std::vector<AngleSummary>
+solve_angles (std::vector<double> const& angles, bool riskUtil, double oracleAlpha, int nRounds,
+	      DualWealthArray const* pOracleWealth, DualWealthArray const& bidderWealth, bool writeDetails,
+	      SolverOptions const& options, std::vector<MeanPolicy> *policies = 0);
+
+#endif
@@ -0,0 +1,86 @@
+#include "solver_context.h"
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+/*
+  Solves several configurations one after another, then all at once from
+  their own threads, and checks that every horizon comes out the same.
+  Configurations mix the vector solver (unconstrained oracle: risk inflation,
+  testimator, least squares) and the matrix solver (constrained oracle).
+*/
+
+bool
+same (std::vector<AngleSummary> const& a, std::vector<AngleSummary> const& b)
+{
+  if (a.size() != b.size()) return false;
+  for (size_t i=0; i<a.size(); ++i)
+  { if ((a[i].config != b[i].config) || (a[i].horizons.size() != b[i].horizons.size())) return false;
+    for (size_t h=0; h<a[i].horizons.size(); ++h)
+    { HorizonValues const& x (a[i].horizons[h]), &y (b[i].horizons[h]);
+      if ((x.utility != y.utility) || (x.row != y.row) || (x.col != y.col)) return false;
+    }
+  }
+  return true;
+}
+
+
+int  main()
+{
+  std::vector<SolveSpec> specs;
+  { SolveSpec s;                                           // risk inflation oracle, geometric bidder
+    s.risk = true;  s.angles = std::vector<double>(1, 310.0);
+    s.oracle = PlayerSpec { 1.0, 1.0, 1.0 };  s.bidder = PlayerSpec { 0.5, 0.01, 0.5 };  s.nRounds = 100;
+    specs.push_back(s);
+  }
+  { SolveSpec s;                                           // testimator oracle at two angles
+    s.risk = true;  s.angles = { 100.0, 200.0 };
+    s.oracle = PlayerSpec { 1.0, 0.05, 1.0 };  s.bidder = PlayerSpec { 0.5, 0.01, 0.5 };  s.nRounds = 100;
+    specs.push_back(s);
+  }
+  { SolveSpec s;                                           // rejections, least squares oracle, universal bidder
+    s.risk = false;  s.angles = std::vector<double>(1, 45.0);
+    s.oracle = PlayerSpec { 1.0, 0.0, 1.0 };  s.bidder = PlayerSpec { 0.5, 0.0, 0.5 };  s.nRounds = 100;
+    specs.push_back(s);
+  }
+  { SolveSpec s;                                           // constrained oracle, matrix solver with two threads
+    s.risk = true;  s.angles = std::vector<double>(1, 296.565);
+    s.oracle = PlayerSpec { 0.25, 0.0, 0.25 };  s.bidder = PlayerSpec { 0.25, 0.001, 0.25 };  s.nRounds = 20;
+    s.options.nThreads = 2;
+    specs.push_back(s);
+  }
+  { SolveSpec s;                                           // rejections, constrained
+    s.risk = false;  s.angles = std::vector<double>(1, 0.0);
+    s.oracle = PlayerSpec { 0.05, 0.0, 0.05 };  s.bidder = PlayerSpec { 0.5, 0.10, 0.5 };  s.nRounds = 20;
+    specs.push_back(s);
+  }
+  const int n ((int) specs.size());
+
+  std::cout << "TEST: Solving " << n << " configurations one at a time." << std::endl;
+  std::vector<std::vector<AngleSummary>> serial (n);
+  for (int i=0; i<n; ++i)
+    serial[i] = SolverContext(specs[i]).solve();
+
+  std::cout << "TEST: Solving them again, each in its own thread." << std::endl;
+  std::vector<std::vector<AngleSummary>> concurrent (n);
+  std::vector<std::thread> threads;
+  for (int i=0; i<n; ++i)
+    threads.push_back(std::thread([&specs, &concurrent, i] () { concurrent[i] = SolverContext(specs[i]).solve(); }));
+  for (std::thread &t : threads)
+    t.join();
+
+  int nDiffer (0);
+  for (int i=0; i<n; ++i)
+  { const bool ok (same(serial[i], concurrent[i]));
+    if (!ok) ++nDiffer;
+    for (AngleSummary const& a : serial[i])
+    { HorizonValues const& v (a.horizons.back());
+      std::cout << "TEST: " << std::setw(24) << std::left << a.config << std::right << std::setprecision(8)
+		<< std::setw(14) << v.utility << std::setw(14) << v.row << std::setw(14) << v.col
+		<< (ok ? "   same in threads" : "   DIFFERS in threads") << std::endl;
+    }
+  }
+  std::cout << "TEST: " << nDiffer << " of " << n << " configurations differ when solved concurrently." << std::endl;
+  return (0 == nDiffer) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "solver_options.h"
+
+#include "special_functions.h"
+#include "read_utils.h"
+
+#include <iostream>
+
+namespace {
+
+  struct SolverOption
+  {
+    option opt;
+    bool   tensor;                                         // also affects the tensor solver
+  };
+
+  const SolverOption solverOptions[] = {
+    { {"threads",      required_argument, 0, 't'}, true  },
+    { {"warm-start",         no_argument, 0, 'W'}, true  },
+    { {"monotone",           no_argument, 0, 'M'}, true  },
+    { {"table",        required_argument, 0, 'T'}, true  },
+    { {"refine",             no_argument, 0, 'f'}, true  },
+    { {"newton",             no_argument, 0, 'N'}, true  },
+    { {"prune",              no_argument, 0, 'P'}, true  },
+    { {"accuracy",     required_argument, 0, 'A'}, true  },
+    { {"all-horizons",       no_argument, 0, 'H'}, true  },
+    { {"reachable",          no_argument, 0, 'D'}, true  },
+    { {"stationary",   required_argument, 0, 'S'}, true  },
+    { {"accelerate",         no_argument, 0, 'X'}, true  },
+    { {"bounded",            no_argument, 0, 'K'}, true  },
+    { {"spill",              no_argument, 0, 'Y'}, true  },
+    { {"quantize",           no_argument, 0, 'Q'}, true  },
+    { {"archive",            no_argument, 0, 'Z'}, true  },
+    { {"io-queue",     required_argument, 0, 'U'}, true  },
+    { {"lockstep",           no_argument, 0, 'L'}, false },    // vector solver
+    { {"precision",    required_argument, 0, 'p'}, false },    // space-conserving matrix and vector solvers
+    { {"checkpoint",   required_argument, 0, 'c'}, false },    // space-conserving matrix solver
+    { {"resume",             no_argument, 0, 'e'}, false }
+  };
+
+  const int nSolverOptions (sizeof(solverOptions) / sizeof(SolverOption));
+
+  bool
+  in_scope (SolverOption const& o, SolverOptionScope scope)
+  {
+    return o.tensor || (allSolverOptions == scope);
+  }
+}
+
+
+std::vector<option>
+with_solver_options (std::vector<option> const& programOptions, SolverOptionScope scope)
+{
+  std::vector<option> options (programOptions);
+  for (int i=0; i<nSolverOptions; ++i)
+    if (in_scope(solverOptions[i], scope))
+      options.push_back(solverOptions[i].opt);
+  const option terminator = {0, 0, 0, 0};
+  options.push_back(terminator);
+  return options;
+}
+
+
+std::string
+with_solver_letters (std::string const& programLetters, SolverOptionScope scope)
+{
+  std::string letters (programLetters);
+  for (int i=0; i<nSolverOptions; ++i)
+    if (in_scope(solverOptions[i], scope))
+    { letters += (char) solverOptions[i].opt.val;
+      if (required_argument == solverOptions[i].opt.has_arg)
+	letters += ':';
+    }
+  return letters;
+}
+
+
+bool
+parse_solver_option (int key, char const* arg, SolverOptions &options)
+{
+  switch (key)
+  {
+  case 't' : { options.nThreads = read_utils::lexical_cast<int>(arg); break; }
+  case 'W' : { options.warmStart = true; break; }
+  case 'M' : { options.monotone = true; break; }
+  case 'T' : { options.tableStep = read_utils::lexical_cast<double>(arg); break; }
+  case 'f' : { options.refineTable = true; break; }
+  case 'N' : { options.newton = true; break; }
+  case 'P' : { options.prune = true; break; }
+  case 'H' : { options.allHorizons = true; break; }
+  case 'D' : { options.reachable = true; break; }
+  case 'S' : { options.stationaryTol = read_utils::lexical_cast<double>(arg); break; }
+  case 'X' : { options.accelerate = true; break; }
+  case 'K' : { options.boundedMemory = true; break; }
+  case 'Y' : { options.boundedMemory = options.spillRounds = true; break; }
+  case 'Q' : { options.boundedMemory = options.quantizePolicy = true; break; }
+  case 'Z' : { options.archivePath = true; break; }
+  case 'U' : { options.ioQueue = read_utils::lexical_cast<int>(arg); break; }
+  case 'L' : { options.lockstep = true; break; }
+  case 'c' : { options.checkpointEvery = read_utils::lexical_cast<int>(arg); break; }
+  case 'e' : { options.resume = true; break; }
+  case 'p' :
+    {
+      if (!parse_precision(arg, &options.precision))
+	std::cout << "PARSE: Precision " << arg << " is not float, mixed or double; using " << precision_name(options.precision) << ".\n";
+      break;
+    }
+  case 'A' :
+    {
+      Special::Accuracy accuracy;
+      if (Special::parse_accuracy(arg, &accuracy))
+	Special::set_accuracy(accuracy);
+      else
+	std::cout << "PARSE: Accuracy " << arg << " is not exact, 1e-10 or 1e-7; using " << Special::name(Special::accuracy()) << ".\n";
+      break;
+    }
+  default:
+    return false;
+  }
+  return true;
+}
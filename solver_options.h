@@ -0,0 +1,37 @@
+#ifndef _SOLVER_OPTIONS_H_
+#define _SOLVER_OPTIONS_H_
+
+#include "bellman.h"
+
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+/***********************************************************************************
+
+  Command-line options of the solvers (SolverOptions and the accuracy of the
+  normal functions), shared by the programs that solve: bellman and optimize.
+
+  One table holds the long name, letter and argument of each.  A program puts
+  its own options (those of the problem being solved) ahead of them for
+  getopt_long and hands any letter it does not know to parse_solver_option.
+  Some options only affect the space-conserving matrix and vector solvers; a
+  program that runs only the tensor solver leaves them out.
+
+***********************************************************************************/
+
+enum SolverOptionScope { tensorSolverOptions, allSolverOptions };
+
+//  Options of the program followed by those of the solvers in scope, ending with the terminator of getopt_long
+std::vector<option>
+with_solver_options (std::vector<option> const& programOptions, SolverOptionScope scope);
+
+//  Letters of the program followed by those of the solvers in scope (colon after those taking a value)
+std::string
+with_solver_letters (std::string const& programLetters, SolverOptionScope scope);
+
+//  Sets the solver option of this letter from its argument; false if the letter is not that of a solver option
+bool
+parse_solver_option (int key, char const* arg, SolverOptions &options);
+
+#endif
@@ -0,0 +1,376 @@
+#include "special_functions.h"
+
+//  Comparisons may not trap, so that the vectorizer can evaluate both sides of a choice;
+//  no fused multiply-add, so that every instruction set gets the same digits
+#pragma GCC optimize ("no-trapping-math", "fp-contract=off")
+
+#include "normal.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+//     Kernels     Kernels     Kernels     Kernels     Kernels     Kernels     Kernels     Kernels     Kernels
+
+//  Written for the vectorizer: no calls (even sqrt, which may set errno), no branches
+//  (both sides of a choice are evaluated), and bit operations on 64-bit integers in
+//  place of conversions between integers and doubles, which AVX2 lacks.
+
+namespace {
+
+inline uint64_t bits_of   (double x)   { uint64_t b; memcpy(&b, &x, sizeof(b)); return b; }
+inline double   double_of (uint64_t b) { double x; memcpy(&x, &b, sizeof(x)); return x; }
+
+const double ln2Hi (6.93147180369123816490e-01);            // ln 2 = ln2Hi + ln2Lo, n*ln2Hi exact for |n| < 2^11
+const double ln2Lo (1.90821492927058770002e-10);
+const double rootTwoPi (2.50662827463100050242);
+
+const double inverseFactorial[14] = { 1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040, 1.0/40320, 1.0/362880,
+				      1.0/3628800, 1.0/39916800, 1.0/479001600, 1.0/6227020800.0 };
+
+
+//  exp(x) for x in [-708, 709], x clamped to that range.  x = n ln 2 + r with |r| <= ln2/2,
+//  so exp(x) = 2^n exp(r) with exp(r) from its Taylor series to the given degree: relative
+//  error 2e-16 for degree 13, 6e-9 for degree 7.
+
+template <int degree>
+inline double exp_kernel (double x)
+{
+  const double shifter (6755399441055744.0);                  // 1.5 * 2^52: the sum rounds x/ln2 to an integer
+  x = (x < -708.0) ? -708.0 : ((709.0 < x) ? 709.0 : x);
+  const double t (x * 1.44269504088896340736 + shifter);
+  const double n (t - shifter);
+  const double r ((x - n * ln2Hi) - n * ln2Lo);
+  double p (inverseFactorial[degree]);
+  for (int k=degree-1; 0<=k; --k)
+    p = p * r + inverseFactorial[k];
+  const uint64_t k (bits_of(t) - bits_of(shifter));           // n in two's complement
+  return p * double_of((k + 1023) << 52);
+}
+
+
+//  log(x) for normal x > 0; relative error 2e-16.  x = 2^e m with m in [sqrt(1/2), sqrt(2)),
+//  and log m = 2 atanh(s) = 2(s + s^3/3 + ...) with s = (m-1)/(m+1), |s| < 0.172.
+
+inline double log_kernel (double x)
+{
+  const uint64_t b (bits_of(x));
+  const double   e0 (double_of((b >> 52) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0));
+  const double   m0 (double_of((b & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL));
+  const bool     big (1.41421356237309504880 < m0);
+  const double   m (big ? 0.5 * m0 : m0);
+  const double   e (big ? e0 + 1.0 : e0);
+  const double   s ((m - 1.0)/(m + 1.0));
+  const double   s2 (s * s);
+  double p (1.0/21.0);
+  p = p * s2 + 1.0/19.0;
+  p = p * s2 + 1.0/17.0;
+  p = p * s2 + 1.0/15.0;
+  p = p * s2 + 1.0/13.0;
+  p = p * s2 + 1.0/11.0;
+  p = p * s2 + 1.0/9.0;
+  p = p * s2 + 1.0/7.0;
+  p = p * s2 + 1.0/5.0;
+  p = p * s2 + 1.0/3.0;
+  return e * ln2Hi + (e * ln2Lo + 2.0 * s * (1.0 + s2 * p));
+}
+
+
+//  sqrt(x) for normal x > 0 from exp and log, then a Newton step
+
+inline double sqrt_kernel (double x)
+{
+  const double s (exp_kernel<13>(0.5 * log_kernel(x)));
+  return 0.5 * (s + x / s);
+}
+
+
+template <int degree>
+inline double density_kernel (double x)
+{
+  return exp_kernel<degree>(-0.5 * x * x) / rootTwoPi;
+}
+
+
+//  Hart's rational approximation to Phi(-|x|) for |x| < 7.07, a continued fraction beyond;
+//  max abs error 5e-15.
+
+inline double cdf_tight_kernel (double x)
+{
+  const double ax (fabs(x));
+  const double e  (exp_kernel<13>(-0.5 * ax * ax));
+  double num (3.52624965998911e-02);
+  num = num * ax + 0.700383064443688;
+  num = num * ax + 6.37396220353165;
+  num = num * ax + 33.912866078383;
+  num = num * ax + 112.079291497871;
+  num = num * ax + 221.213596169931;
+  num = num * ax + 220.206867912376;
+  double den (8.83883476483184e-02);
+  den = den * ax + 1.75566716318264;
+  den = den * ax + 16.064177579207;
+  den = den * ax + 86.7807322029461;
+  den = den * ax + 296.564248779674;
+  den = den * ax + 637.333633378831;
+  den = den * ax + 793.826512519948;
+  den = den * ax + 440.413735824752;
+  double cf (ax + 0.65);                                      // Phi(-x) = phi(x)/(x + 1/(x + 2/(x + ...)))
+  for (int k=8; 0<k; --k)
+    cf = ax + k/cf;
+  double tail ((ax < 7.07106781186547) ? e * num / den : e / (cf * rootTwoPi));
+  tail = (37.0 < ax) ? 0.0 : tail;
+  return (0.0 < x) ? 1.0 - tail : tail;
+}
+
+
+//  erfc(z) = t exp(-z^2 + P(t)) with t = 1/(1+z/2) from Numerical Recipes; relative error 1.2e-7.
+
+inline double cdf_fast_kernel (double x)
+{
+  const double z (fabs(x) * 0.70710678118654752440);
+  const double t (1.0/(1.0 + 0.5 * z));
+  double p (0.17087277);
+  p = p * t - 0.82215223;
+  p = p * t + 1.48851587;
+  p = p * t - 1.13520398;
+  p = p * t + 0.27886807;
+  p = p * t - 0.18628806;
+  p = p * t + 0.09678418;
+  p = p * t + 0.37409196;
+  p = p * t + 1.00002368;
+  p = p * t - 1.26551223;
+  const double tail (0.5 * t * exp_kernel<7>(p - z * z));
+  return (0.0 < x) ? 1.0 - tail : tail;
+}
+
+
+//  Acklam's rational approximations, relative error 1.15e-9
+
+inline double quantile_fast_kernel (double p)
+{
+  const double pLow (0.02425);
+  const double pt (((1.0 - p) < p) ? 1.0 - p : p);
+  const double q (sqrt_kernel(-2.0 * log_kernel(pt)));               // tails
+  double c (-7.784894002430293e-03);
+  c = c * q - 3.223964580411365e-01;
+  c = c * q - 2.400758277161838e+00;
+  c = c * q - 2.549732539343734e+00;
+  c = c * q + 4.374664141464968e+00;
+  c = c * q + 2.938163982698783e+00;
+  double d (7.784695709041462e-03);
+  d = d * q + 3.224671290700398e-01;
+  d = d * q + 2.445134137142996e+00;
+  d = d * q + 3.754408661907416e+00;
+  d = d * q + 1.0;
+  const double u (p - 0.5);                                   // central region
+  const double r (u * u);
+  double a (-3.969683028665376e+01);
+  a = a * r + 2.209460984245205e+02;
+  a = a * r - 2.759285104469687e+02;
+  a = a * r + 1.383577518672690e+02;
+  a = a * r - 3.066479806614716e+01;
+  a = a * r + 2.506628277459239e+00;
+  double b (-5.447609879822406e+01);
+  b = b * r + 1.615858368580409e+02;
+  b = b * r - 1.556989798598866e+02;
+  b = b * r + 6.680131188771972e+01;
+  b = b * r - 1.328068155288572e+01;
+  b = b * r + 1.0;
+  const double tail (c/d);
+  return (p < pLow) ? tail : (((1.0 - pLow) < p) ? -tail : u * a / b);
+}
+
+
+//  One Halley step on Phi(x) = p from Acklam's value; not taken beyond |x| = 37 where
+//  the tight Phi is zero.
+
+inline double quantile_tight_kernel (double p)
+{
+  const double x (quantile_fast_kernel(p));
+  const double e (cdf_tight_kernel(x) - p);
+  const double u (e * rootTwoPi * exp_kernel<13>(0.5 * x * x));
+  const double step (u / (1.0 + 0.5 * x * u));
+  return (fabs(x) < 37.0) ? x - step : x;
+}
+
+
+//     Dispatch     Dispatch     Dispatch     Dispatch     Dispatch     Dispatch     Dispatch     Dispatch
+
+typedef double (*Kernel)(double);
+typedef void   (*Batch)(int n, double const* x, double *y);
+
+template <Kernel K>
+void batch_sse2 (int n, double const* x, double *y)
+{
+  for (int i=0; i<n; ++i) y[i] = K(x[i]);
+}
+
+template <Kernel K>
+__attribute__((target("avx2")))
+void batch_avx2 (int n, double const* x, double *y)
+{
+  for (int i=0; i<n; ++i) y[i] = K(x[i]);
+}
+
+template <Kernel K>
+__attribute__((target("avx512f,prefer-vector-width=512")))
+void batch_avx512 (int n, double const* x, double *y)
+{
+  for (int i=0; i<n; ++i) y[i] = K(x[i]);
+}
+
+enum KernelIndex { cdfTight, cdfFast, densityTight, densityFast, quantileTight, quantileFast, nKernels };
+
+const Batch batches[3][nKernels] =
+  { { batch_sse2<cdf_tight_kernel>,     batch_sse2<cdf_fast_kernel>,
+      batch_sse2<density_kernel<13> >,  batch_sse2<density_kernel<7> >,
+      batch_sse2<quantile_tight_kernel>,   batch_sse2<quantile_fast_kernel>   },
+    { batch_avx2<cdf_tight_kernel>,     batch_avx2<cdf_fast_kernel>,
+      batch_avx2<density_kernel<13> >,  batch_avx2<density_kernel<7> >,
+      batch_avx2<quantile_tight_kernel>,   batch_avx2<quantile_fast_kernel>   },
+    { batch_avx512<cdf_tight_kernel>,   batch_avx512<cdf_fast_kernel>,
+      batch_avx512<density_kernel<13> >, batch_avx512<density_kernel<7> >,
+      batch_avx512<quantile_tight_kernel>, batch_avx512<quantile_fast_kernel> } };
+
+// settings of the process, read by solves in any thread
+std::atomic<Special::Accuracy> theAccuracy (Special::exact);
+std::atomic<Special::ISA>      theIsa      (Special::best_isa());
+
+}
+
+
+//     Settings     Settings     Settings     Settings     Settings     Settings     Settings     Settings
+
+Special::Accuracy
+Special::accuracy ()
+{
+  return theAccuracy.load(std::memory_order_relaxed);
+}
+
+void
+Special::set_accuracy (Accuracy a)
+{
+  theAccuracy = a;
+}
+
+bool
+Special::parse_accuracy (std::string const& s, Accuracy *a)
+{
+  if (s == "exact")
+    *a = exact;
+  else if ((s == "1e-10") || (s == "tight"))
+    *a = tight;
+  else if ((s == "1e-7") || (s == "fast"))
+    *a = fast;
+  else
+    return false;
+  return true;
+}
+
+const char*
+Special::name (Accuracy a)
+{
+  switch (a)
+  { case tight: return "1e-10";
+    case fast : return "1e-7";
+    default   : return "exact";
+  }
+}
+
+Special::ISA
+Special::best_isa ()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return avx2;
+  return sse2;
+}
+
+Special::ISA
+Special::isa ()
+{
+  return theIsa.load(std::memory_order_relaxed);
+}
+
+void
+Special::set_isa (ISA i)
+{
+  const ISA best (best_isa());
+  theIsa = (i < best) ? i : best;
+}
+
+const char*
+Special::name (ISA i)
+{
+  switch (i)
+  { case avx512: return "AVX-512";
+    case avx2  : return "AVX2";
+    default    : return "SSE2";
+  }
+}
+
+
+//     Scalar     Scalar     Scalar     Scalar     Scalar     Scalar     Scalar     Scalar     Scalar     Scalar
+
+double
+Special::cdf (double x, Accuracy a)
+{
+  switch (a)
+  { case tight: return cdf_tight_kernel(x);
+    case fast : return cdf_fast_kernel(x);
+    default   : return normal_cdf(x);
+  }
+}
+
+double
+Special::density (double x, Accuracy a)
+{
+  switch (a)
+  { case tight: return density_kernel<13>(x);
+    case fast : return density_kernel<7>(x);
+    default   : return normal_density(x);
+  }
+}
+
+double
+Special::quantile (double p, Accuracy a)
+{
+  switch (a)
+  { case tight: return quantile_tight_kernel(p);
+    case fast : return quantile_fast_kernel(p);
+    default   : return normal_quantile(p);
+  }
+}
+
+
+//     Batch     Batch     Batch     Batch     Batch     Batch     Batch     Batch     Batch     Batch     Batch
+
+void
+Special::cdf (int n, double const* x, double *p, Accuracy a)
+{
+  if (exact == a)
+    for (int i=0; i<n; ++i) p[i] = normal_cdf(x[i]);
+  else
+    batches[Special::isa()][(tight == a) ? cdfTight : cdfFast](n, x, p);
+}
+
+void
+Special::density (int n, double const* x, double *d, Accuracy a)
+{
+  if (exact == a)
+    for (int i=0; i<n; ++i) d[i] = normal_density(x[i]);
+  else
+    batches[Special::isa()][(tight == a) ? densityTight : densityFast](n, x, d);
+}
+
+void
+Special::quantile (int n, double const* p, double *x, Accuracy a)
+{
+  if (exact == a)
+    for (int i=0; i<n; ++i) x[i] = normal_quantile(p[i]);
+  else
+    batches[Special::isa()][(tight == a) ? quantileTight : quantileFast](n, p, x);
+}
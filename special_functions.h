@@ -0,0 +1,73 @@
+#ifndef _SPECIAL_FUNCTIONS_H_
+#define _SPECIAL_FUNCTIONS_H_
+
+#include <string>
+
+/***********************************************************************************
+
+  Normal cdf Phi, density phi and quantile Phi^{-1}, for a single argument or
+  a batch of arguments.
+
+  Each comes in three accuracy tiers:
+
+     exact   the library functions of normal.h, one call per argument.
+     tight   max abs error 1e-10.  Measured against the library: 2e-16 for Phi
+             and phi; relative error 3e-9 for Phi in the lower tail and 1e-10 for
+             the quantile on [1e-300, 1/2].  Phi uses Hart's rational approximation
+             (as given by West, 2005) below 7.07 and a continued fraction beyond;
+             the quantile takes a Halley step from Acklam's approximation.
+     fast    max abs error 1e-7.  Measured: 4e-8 for Phi (relative 1.2e-7), 2e-9
+             for phi, relative error 1.2e-9 for the quantile.  Phi uses the
+             Chebyshev fit to erfc of Numerical Recipes with a shorter exp; the
+             quantile is Acklam's without refinement.
+
+  Above 1/2, the quantile is limited by the rounding of p, so z_alpha asks
+  for the lower tail in the tight and fast tiers.
+
+  The tight and fast tiers are written without library calls or branches (exp
+  and log are computed in place and both sides of each test are evaluated), so
+  the batch loops vectorize.  They are compiled for SSE2, AVX2 and AVX-512, and
+  the batch functions dispatch on the best instruction set the processor has,
+  found at startup (set_isa lowers it, for testing).  Every instruction set gets
+  the same digits, as do the scalar functions.  One at a time, these run about
+  as fast as the library; the gain comes in batches (see the times reported
+  by special_functions.test).
+
+  reject_prob, risk and z_alpha in utility.cc use the tier accuracy(), set by
+  the --accuracy option of the programs before the utilities are built.  The
+  default is exact, which reproduces the library calls digit for digit.  The
+  accuracy and instruction set are settings of the process; solves running in
+  several threads read them, so set them before starting any.
+
+***********************************************************************************/
+
+namespace Special
+{
+  enum Accuracy { exact, tight, fast };
+
+  enum ISA { sse2, avx2, avx512 };
+
+  Accuracy    accuracy ();
+  void        set_accuracy (Accuracy a);
+  bool        parse_accuracy (std::string const& s, Accuracy *a);  // exact, 1e-10, 1e-7
+  const char* name (Accuracy a);
+
+  ISA         best_isa ();                                         // supported by this processor
+  ISA         isa ();                                              // used by the batch functions
+  void        set_isa (ISA i);                                     // not above best_isa()
+  const char* name (ISA i);
+
+  double      cdf      (double x, Accuracy a);
+  double      density  (double x, Accuracy a);
+  double      quantile (double p, Accuracy a);                     // 0 < p < 1
+
+  inline double cdf      (double x) { return cdf(x, accuracy());      }
+  inline double density  (double x) { return density(x, accuracy());  }
+  inline double quantile (double p) { return quantile(p, accuracy()); }
+
+  void        cdf      (int n, double const* x, double *p, Accuracy a);
+  void        density  (int n, double const* x, double *d, Accuracy a);
+  void        quantile (int n, double const* p, double *x, Accuracy a);
+}
+
+#endif
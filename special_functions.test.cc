@@ -0,0 +1,122 @@
+/*
+  Accuracy and throughput of the normal special functions.
+
+  For each accuracy tier and each instruction set the processor has, reports the
+  max abs and relative errors of the batch cdf and density on a grid over [-40, 40]
+  (relative where the value exceeds 1e-290), the max relative error of the quantile
+  on p = 10^-k over [1e-300, 0.5], and the number of batch values that differ from
+  the scalar functions.  Errors are measured against the exact tier (the library
+  functions), so the exact rows show zeros.  (Above 1/2, the quantile is limited
+  by the rounding of p.)  Then reports the time per value of each function.
+*/
+
+#include "special_functions.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <math.h>
+
+
+const Special::Accuracy tiers[] = { Special::exact, Special::tight, Special::fast };
+
+
+struct Errors
+{
+  double abs, rel;
+  int    mismatches;
+};
+
+
+template <class Batch, class Scalar>
+Errors
+errors (std::vector<double> const& x, Batch batch, Scalar scalar, Special::Accuracy a)
+{
+  const int n ((int) x.size());
+  std::vector<double> exact(n), y(n);
+  batch(n, &x[0], &exact[0], Special::exact);
+  batch(n, &x[0], &y[0], a);
+  Errors e = { 0.0, 0.0, 0 };
+  for (int i=0; i<n; ++i)
+  { const double d (fabs(y[i] - exact[i]));
+    e.abs = std::max(e.abs, d);
+    if (1.0e-290 < fabs(exact[i]))
+      e.rel = std::max(e.rel, d/fabs(exact[i]));
+    if (y[i] != scalar(x[i], a))
+      ++e.mismatches;
+  }
+  return e;
+}
+
+
+template <class Batch>
+double
+nanoseconds_per_value (std::vector<double> const& x, Batch batch, Special::Accuracy a)
+{
+  const int n ((int) x.size());
+  const int reps (20);
+  std::vector<double> y(n);
+  double sum (0.0);
+  auto start = std::chrono::steady_clock::now();
+  for (int r=0; r<reps; ++r)
+  { batch(n, &x[0], &y[0], a);
+    sum += y[n/2];
+  }
+  auto stop = std::chrono::steady_clock::now();
+  if (sum == 12345.0) std::cout << " ";                         // keep the calls
+  return std::chrono::duration<double,std::nano>(stop-start).count() / (reps * (double) n);
+}
+
+
+void cdf_batch      (int n, double const* x, double *y, Special::Accuracy a) { Special::cdf(n, x, y, a); }
+void density_batch  (int n, double const* x, double *y, Special::Accuracy a) { Special::density(n, x, y, a); }
+void quantile_batch (int n, double const* x, double *y, Special::Accuracy a) { Special::quantile(n, x, y, a); }
+
+double cdf_scalar      (double x, Special::Accuracy a) { return Special::cdf(x, a); }
+double density_scalar  (double x, Special::Accuracy a) { return Special::density(x, a); }
+double quantile_scalar (double p, Special::Accuracy a) { return Special::quantile(p, a); }
+
+
+int main()
+{
+  std::vector<double> xs, ps;
+  for (int i=-40000; i<=40000; ++i)
+    xs.push_back(i/1000.0 + 1.0e-7);                              // avoid exact grid points
+  for (double k=300; k>=0.301; k -= 0.01)
+    ps.push_back(pow(10.0, -k));
+
+  const Special::ISA best (Special::best_isa());
+  std::cout << "TEST: best instruction set is " << Special::name(best) << std::endl;
+
+  std::cout << "\nTEST: accuracy (errors relative to the exact tier; mismatches are batch values that differ from scalar)\n"
+	    << "   ISA      tier           cdf abs      rel     density abs      rel    quantile rel   mismatches" << std::endl;
+  for (int i=Special::sse2; i<=best; ++i)
+  { Special::set_isa((Special::ISA) i);
+    for (Special::Accuracy a : tiers)
+    { Errors c (errors(xs, cdf_batch, cdf_scalar, a));
+      Errors d (errors(xs, density_batch, density_scalar, a));
+      Errors q (errors(ps, quantile_batch, quantile_scalar, a));
+      std::cout << "   " << std::setw(8) << std::left << Special::name(Special::isa()) << " " << std::setw(6) << Special::name(a)
+		<< std::right << std::scientific << std::setprecision(2)
+		<< std::setw(15) << c.abs << std::setw(10) << c.rel << std::setw(15) << d.abs << std::setw(10) << d.rel
+		<< std::setw(15) << q.rel << std::setw(13) << (c.mismatches + d.mismatches + q.mismatches) << std::endl;
+    }
+  }
+
+  std::cout << "\nTEST: throughput (nanoseconds per value, batches of " << xs.size() << ")\n"
+	    << "   ISA      tier          cdf    density   quantile" << std::endl;
+  std::vector<double> pTime (ps);
+  while (pTime.size() < xs.size()) pTime.insert(pTime.end(), ps.begin(), ps.end());
+  pTime.resize(xs.size());
+  for (int i=Special::sse2; i<=best; ++i)
+  { Special::set_isa((Special::ISA) i);
+    for (Special::Accuracy a : tiers)
+      std::cout << "   " << std::setw(8) << std::left << Special::name(Special::isa()) << " " << std::setw(6) << Special::name(a)
+		<< std::right << std::fixed << std::setprecision(2)
+		<< std::setw(13) << nanoseconds_per_value(xs, cdf_batch, a)
+		<< std::setw(11) << nanoseconds_per_value(xs, density_batch, a)
+		<< std::setw(11) << nanoseconds_per_value(pTime, quantile_batch, a) << std::endl;
+  }
+  return 0;
+}
@@ -29,7 +29,7 @@ UniversalRule::identifier () const
   return "Univ()";
 }
 
-static double ln2 =0.69314718055994530942;
+static const double ln2 =0.69314718055994530942;
 
 			   double
 UniversalRule::operator()(double w) const
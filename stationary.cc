@@ -0,0 +1,135 @@
+#include "stationary.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+//     StationaryMonitor     StationaryMonitor     StationaryMonitor     StationaryMonitor     StationaryMonitor
+
+double
+StationaryMonitor::track (int s, double increment)
+{
+  const double change (fabs(increment - mIncrement[s]));
+  mIncrement[s] = increment;
+  return change;
+}
+
+
+template <class Scalar>
+bool
+StationaryMonitor::update (BasicValuePlanes<Scalar> const& src, BasicValuePlanes<Scalar> const& dest, std::pair<int,int> zeroIndex)
+{
+  const ValuePlanes::Plane planes[3] = { ValuePlanes::utility, ValuePlanes::row, ValuePlanes::col };
+  const int nRows (dest.rows()-1), nCols (dest.cols()-1);                 // omit padding
+  if (mIncrement.empty()) mIncrement.resize(nRows*nCols);
+  mChange = 0.0;
+  int i (0);
+  for (int r=0; r<nRows; ++r)
+    for (int c=0; c<nCols; ++c, ++i)
+      mChange = std::max(mChange, track(i, (double) dest(r,c,ValuePlanes::utility) - (double) src(r,c,ValuePlanes::utility)));
+  Values value, drift;
+  for (int k=0; k<3; ++k)
+  { value.v[k] = dest(zeroIndex.first, zeroIndex.second, planes[k]);
+    drift.v[k] = (double) dest(zeroIndex.first, zeroIndex.second, planes[k]) - (double) src(zeroIndex.first, zeroIndex.second, planes[k]);
+  }
+  return record(value, drift);
+}
+
+
+template <class M>
+bool
+StationaryMonitor::update (M const& utility, M const& oracle, M const& bidder, int r, int prior, int nStates, int zeroIndex)
+{
+  M const* mats[3] = { &utility, &oracle, &bidder };
+  if (mIncrement.empty()) mIncrement.resize(nStates);
+  mChange = 0.0;
+  for (int s=0; s<nStates; ++s)
+    mChange = std::max(mChange, track(s, utility(r,s) - utility(prior,s)));
+  Values value, drift;
+  for (int k=0; k<3; ++k)
+  { value.v[k] = (*mats[k])(r,zeroIndex);
+    drift.v[k] = (*mats[k])(r,zeroIndex) - (*mats[k])(prior,zeroIndex);
+  }
+  return record(value, drift);
+}
+
+template bool StationaryMonitor::update (BasicValuePlanes<float>  const&, BasicValuePlanes<float>  const&, std::pair<int,int>);
+template bool StationaryMonitor::update (BasicValuePlanes<double> const&, BasicValuePlanes<double> const&, std::pair<int,int>);
+template bool StationaryMonitor::update (Eigen::MatrixXf const&, Eigen::MatrixXf const&, Eigen::MatrixXf const&, int, int, int, int);
+template bool StationaryMonitor::update (Eigen::MatrixXd const&, Eigen::MatrixXd const&, Eigen::MatrixXd const&, int, int, int, int);
+
+
+bool
+StationaryMonitor::record (Values const& value, Values const& drift)
+{
+  ++mRounds;
+  mValue = value;
+  mDrift[2] = mDrift[1];
+  mDrift[1] = mDrift[0];
+  mDrift[0] = drift;
+  mEstimate.push_back(extrapolate(mTarget));
+  const int w (std::max(2, mRounds/4));                                    // window
+  mRemaining = std::numeric_limits<double>::infinity();
+  if (2*w < mRounds)
+  { Values const& e0 (mEstimate[mRounds-1]);
+    Values const& e1 (mEstimate[mRounds-1-w]);
+    Values const& e2 (mEstimate[mRounds-1-2*w]);
+    mRemaining = 0.0;
+    for (int k=0; k<3; ++k)
+    { const double last  (fabs(e0.v[k] - e1.v[k]));
+      const double prior (fabs(e1.v[k] - e2.v[k]));
+      double remaining (0.0);
+      if (0.0 < last)
+      { const double rho ((0.0 < prior) ? last/prior : 1.0);
+	remaining = (rho < 1.0) ? last * rho / (1.0 - rho) : std::numeric_limits<double>::infinity();
+      }
+      mRemaining = std::max(mRemaining, remaining);
+    }
+  }
+  return (mChange <= mTolerance) && (mRemaining <= mTolerance);
+}
+
+
+bool
+StationaryMonitor::geometric (int k, double *g, double *rho) const
+{
+  const double d0 (mDrift[0].v[k]), d1 (mDrift[1].v[k]), d2 (mDrift[2].v[k]);
+  *g = d0;
+  *rho = 0.0;
+  if (!mAccelerate || (mRounds < 3) || (d1 == d2))
+    return false;
+  const double r ((d0 - d1)/(d1 - d2));
+  if (!((0.0 < r) && (r < 1.0)))
+    return false;
+  *rho = r;
+  *g = d0 + (d0 - d1) * r / (1.0 - r);                                     // Aitken limit of the increments
+  return true;
+}
+
+
+StationaryMonitor::Values
+StationaryMonitor::drift () const
+{
+  Values result;
+  for (int k=0; k<3; ++k)
+  { double rho;
+    geometric(k, &result.v[k], &rho);
+  }
+  return result;
+}
+
+
+StationaryMonitor::Values
+StationaryMonitor::extrapolate (int n) const
+{
+  const int m (n - mRounds);                                               // rounds beyond those solved
+  Values result;
+  for (int k=0; k<3; ++k)
+  { double g, rho;
+    if (geometric(k, &g, &rho))                                            // d_{h+j} = g + (d_h - g) rho^j
+      result.v[k] = mValue.v[k] + m * g + (mDrift[0].v[k] - g) * rho * (1.0 - pow(rho, m)) / (1.0 - rho);
+    else
+      result.v[k] = mValue.v[k] + m * mDrift[0].v[k];
+  }
+  return result;
+}
@@ -0,0 +1,96 @@
+#ifndef _STATIONARY_H_
+#define _STATIONARY_H_
+
+#include "value_planes.h"
+
+#include <utility>
+#include <vector>
+
+/***********************************************************************************
+
+  Detects when a backward recursion has become stationary, so that the value
+  of a long horizon can be extrapolated from a shorter one.
+
+  The recursion does not depend on the round, so once the optimal policy
+  settles, each round adds the same amount (the drift) to the utility, row and
+  column values of a state.  This is relative value iteration: the increments
+  d_h = V_h - V_{h-1} converge, and the values themselves need not.  The value
+  at the start after n rounds is then V_h + (n-h) d_h, for any n > h.
+
+  After each round, the monitor finds the largest change in the increments of
+  the utility of any state from those of the prior round, and extrapolates the
+  three values at the start to the target horizon.  (The row and column values
+  of states far from the start can keep jumping when the utility ties at two
+  means, so only the utility is checked over all states.)  The recursion is
+  stationary when both
+    - the increments of the utility change by at most the tolerance, and
+    - the extrapolated values are expected to move by at most the tolerance
+      from here on, judging from their changes over the last two windows of
+      h/4 rounds (if changes shrink by the factor rho each window, what
+      remains of a change delta is delta rho/(1-rho)).  Windows rather than
+      single rounds, since the increments at one state can repeat for a few
+      rounds before moving on.
+  The second test matters when increments decay slowly (as 1/h, say, in
+  which case the drift is zero and values grow like log n): the increments
+  then change little from round to round, but the extrapolation keeps moving,
+  so the solver runs on.
+
+  With acceleration, the extrapolation adds the geometric tail of the
+  increments at the start: if d_h = g + c rho^h, Aitken's delta-squared
+  estimates rho and the limit g from the last three increments, and the sum
+  of the remaining increments follows.  When the increments are geometric, the
+  corrected extrapolation settles within a few rounds, well before the
+  increments themselves do.  Where rho is not in (0,1), the plain rule is used.
+
+  Float and mixed value planes (see SolverOptions::precision) store floats, so
+  tolerances much below 1e-7 times the size of the values cannot be met with
+  them; double planes allow tighter tolerances.
+
+***********************************************************************************/
+
+class StationaryMonitor
+{
+ public:
+  struct Values { double v[3]; };                          // utility, row, col (or utility, oracle, bidder)
+
+ private:
+  const double           mTolerance;
+  const bool             mAccelerate;
+  const int              mTarget;                          // horizon extrapolated to
+  int                    mRounds;                          // rounds seen
+  std::vector<double>    mIncrement;                       // last increments of the utility, by state
+  double                 mChange;                          // largest change in these
+  double                 mRemaining;                       // expected further change of the extrapolation
+  Values                 mValue;                           // at the start after the last round
+  Values                 mDrift[3];                        // increments at the start, last first
+  std::vector<Values>    mEstimate;                        // extrapolation after each round
+
+ public:
+
+  StationaryMonitor (double tolerance, bool accelerate, int target)
+    : mTolerance(tolerance), mAccelerate(accelerate), mTarget(target), mRounds(0), mIncrement(),
+      mChange(0.0), mRemaining(0.0), mValue(), mDrift(), mEstimate() { }
+
+  int    rounds()            const { return mRounds; }
+  double change()            const { return mChange; }
+  double remaining()         const { return mRemaining; }
+  Values drift()             const;                        // per round at the start (the limit g if accelerated)
+
+  // matrix solvers: after each round, with the planes before and after; true once stationary
+  template <class Scalar>
+  bool   update (BasicValuePlanes<Scalar> const& src, BasicValuePlanes<Scalar> const& dest, std::pair<int,int> zeroIndex);
+
+  // vector solver: after row r of the three matrices is filled from row prior (r+1, or the other of two rows)
+  template <class M>
+  bool   update (M const& utility, M const& oracle, M const& bidder, int r, int prior, int nStates, int zeroIndex);
+
+  // values at the start after n rounds, n >= rounds()
+  Values extrapolate (int n) const;
+
+ private:
+  double track (int s, double increment);                  // stores the increment of state s, returns change
+  bool   record (Values const& value, Values const& drift);
+  bool   geometric (int k, double *g, double *rho) const;  // limit and rate of increments of value k
+};
+
+#endif
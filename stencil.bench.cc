@@ -0,0 +1,161 @@
+/*
+  Memory behaviour of one backward round of the matrix recursion, without the line search.
+
+  Compares the layout used before the value planes (three column-major float
+  matrices interpolated by reject_value at positions looked up from the wealth
+  arrays, r outer and c inner) with the interleaved value planes read through
+  the tiled transition stencil.  Reports time and cache misses per cell from
+  the hardware counters (when the kernel allows perf_event_open).
+
+  The wealth arrays are universal with the top wealth chosen to give a 300 x 300
+  grid of values; run with a second argument to set omega (default 0.25) and
+  see the effect of longer jumps after a rejection.
+*/
+
+#include "stencil.h"
+#include "value_planes.h"
+#include "utility.h"
+#include "wealth.Template.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+
+class MissCounter
+{
+  int mFd;
+
+ public:
+  MissCounter (unsigned type, unsigned long long config)
+    : mFd(-1)
+    { struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      mFd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+  ~MissCounter() { if (0 <= mFd) close(mFd); }
+
+  bool available() const { return 0 <= mFd; }
+  void start()     const { if (available()) { ioctl(mFd, PERF_EVENT_IOC_RESET, 0); ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0); } }
+  long long stop() const
+    { long long count (-1);
+      if (available())
+      { ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+	if (sizeof(count) != read(mFd, &count, sizeof(count))) count = -1;
+      }
+      return count;
+    }
+};
+
+
+struct Measurement
+{
+  double seconds;
+  long long l1Misses, llcMisses;
+};
+
+template <class F>
+Measurement
+measure (F const& f)
+{
+  MissCounter l1 (PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  MissCounter llc (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  l1.start(); llc.start();
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  auto t1 = std::chrono::steady_clock::now();
+  Measurement m;
+  m.l1Misses  = l1.stop();
+  m.llcMisses = llc.stop();
+  m.seconds = std::chrono::duration<double>(t1-t0).count();
+  return m;
+}
+
+void
+report (std::string label, Measurement const& m, double nCells)
+{
+  std::cout << "BENCH: " << std::setw(18) << std::left << label << std::right
+	    << std::setw(10) << std::setprecision(4) << 1.0e9*m.seconds/nCells << " ns/cell";
+  if (0 <= m.l1Misses)  std::cout << std::setw(10) << m.l1Misses /nCells << " L1D misses/cell";
+  else                  std::cout << "   (no L1D counter)";
+  if (0 <= m.llcMisses) std::cout << std::setw(10) << m.llcMisses/nCells << " LLC misses/cell";
+  else                  std::cout << "   (no LLC counter)";
+  std::cout << std::endl;
+}
+
+
+int  main(int argc, char** argv)
+{
+  const double maxWealth (106.0);              // 298 wealth positions, 299 with padding
+  const int    nRounds   (20);
+  const double w0        (0.5);                // initial wealth, fixed so that omega moves only the reject jump
+  double omega = (argc > 1) ? atof(argv[1]) : 0.25;
+
+  UniversalRule univ;
+  DualWealthArray rowWealth("univ", maxWealth, w0, omega, univ, 200);
+  DualWealthArray colWealth("univ", maxWealth, w0, omega, univ, 200);
+  const int nRows (1+rowWealth.number_wealth_positions());
+  const int nCols (1+colWealth.number_wealth_positions());
+  const double nCells ((double) nRounds * (nRows-1) * (nCols-1));
+  std::cout << "BENCH: " << nRows << " x " << nCols << " grid, w0=" << w0 << ", omega=" << omega << ", " << nRounds << " rounds" << std::endl;
+
+  // before: three column-major matrices, positions from the wealth arrays
+  { Matrix u0 = Matrix::Zero(nRows,nCols), r0 = Matrix::Zero(nRows,nCols), c0 = Matrix::Zero(nRows,nCols);
+    Matrix u1 = Matrix::Constant(nRows,nCols,1.0), r1 = Matrix::Constant(nRows,nCols,1.0), c1 = Matrix::Constant(nRows,nCols,1.0);
+    Measurement m = measure([&] ()
+      { for (int round=0; round<nRounds; ++round)
+	{ Matrix &us (round%2 ? u0 : u1), &rs (round%2 ? r0 : r1), &cs (round%2 ? c0 : c1);
+	  Matrix &ud (round%2 ? u1 : u0), &rd (round%2 ? r1 : r0), &cd (round%2 ? c1 : c0);
+	  for (int r=0; r<nRows-1; ++r)
+	  { WIndex rowBidPos (rowWealth.bid_position(r)), rowRejectPos (rowWealth.reject_position(r));
+	    for (int c=0; c<nCols-1; ++c)
+	    { WIndex colBidPos (colWealth.bid_position(c)), colRejectPos (colWealth.reject_position(c));
+	      ud(r,c) = (float) (reject_value(rowBidPos,colBidPos,us) + reject_value(rowBidPos,colRejectPos,us)
+				 + reject_value(rowRejectPos,colBidPos,us) + reject_value(rowRejectPos,colRejectPos,us));
+	      rd(r,c) = (float) (reject_value(rowBidPos,colBidPos,rs) + reject_value(rowBidPos,colRejectPos,rs)
+				 + reject_value(rowRejectPos,colBidPos,rs) + reject_value(rowRejectPos,colRejectPos,rs));
+	      cd(r,c) = (float) (reject_value(rowBidPos,colBidPos,cs) + reject_value(rowBidPos,colRejectPos,cs)
+				 + reject_value(rowRejectPos,colBidPos,cs) + reject_value(rowRejectPos,colRejectPos,cs));
+	    }
+	  }
+	}
+      });
+    report("separate matrices", m, nCells);
+    std::clog << "BENCH: check " << u0(0,0) << std::endl;
+  }
+
+  // after: interleaved planes read through the tiled stencil
+  { TransitionStencil stencil (rowWealth, colWealth);
+    ValuePlanes p0 (nRows,nCols), p1 (nRows,nCols);
+    Measurement m = measure([&] ()
+      { double v[12];
+	for (int round=0; round<nRounds; ++round)
+	{ ValuePlanes &src (round%2 ? p0 : p1), &dest (round%2 ? p1 : p0);
+	  for (TransitionStencil::Tile const& t : stencil.tiles())
+	  { int cell (t.firstCell);
+	    for (int r=t.r0; r<t.r1; ++r)
+	      for (int c=t.c0; c<t.c1; ++c, ++cell)
+	      { stencil.gather(cell, src, v);
+		dest.set(r, c, v[0]+v[1]+v[2]+v[3], v[4]+v[5]+v[6]+v[7], v[8]+v[9]+v[10]+v[11], 0.0);
+	      }
+	  }
+	}
+      });
+    report("planes + stencil", m, nCells);
+    std::clog << "BENCH: check " << p0(0,0,ValuePlanes::utility) << "  using " << stencil.tiles().size() << " tiles" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "stencil.h"
+
+#include <algorithm>
+#include <unistd.h>   // sysconf
+
+//     TransitionStencil     TransitionStencil     TransitionStencil     TransitionStencil     TransitionStencil
+
+TransitionStencil::TransitionStencil (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, long cacheBytes, int valueBytes)
+  : mRows(1+rowWealth.number_wealth_positions()), mCols(1+colWealth.number_wealth_positions()),   // extra 1 for padding
+    mStride(ValuePlanes::nPlanes*mCols), mTiles(), mRowBid(mRows-1), mColBid(mCols-1)
+{
+  make_tiles(cacheBytes, valueBytes);
+  const int nCells (number_of_cells());
+  for (int q=0; q<4; ++q)
+  { mOffset[q].resize(nCells);
+    for (int k=0; k<4; ++k)
+      mWeight[q][k].resize(nCells);
+  }
+  for (int r=0; r<mRows-1; ++r)  mRowBid[r] = rowWealth.bid(r);
+  for (int c=0; c<mCols-1; ++c)  mColBid[c] = colWealth.bid(c);
+  for (Tile const& t : mTiles)
+  { int cell (t.firstCell);
+    for (int r=t.r0; r<t.r1; ++r)
+    { std::pair<int,double> rowPos[2] = { rowWealth.bid_position(r), rowWealth.reject_position(r) };   // does not reject, rejects
+      for (int c=t.c0; c<t.c1; ++c, ++cell)
+      { std::pair<int,double> colPos[2] = { colWealth.bid_position(c), colWealth.reject_position(c) };
+	for (int q=0; q<4; ++q)                                      // q = 2*(row rejects) + (col rejects)
+	{ std::pair<int,double> const& rp (rowPos[q/2]);
+	  std::pair<int,double> const& cp (colPos[q%2]);
+	  mOffset[q][cell] = ValuePlanes::nPlanes * (rp.first * mCols + cp.first);
+	  mWeight[q][0][cell] =    rp.second  *    cp.second;
+	  mWeight[q][1][cell] =    rp.second  * (1-cp.second);
+	  mWeight[q][2][cell] = (1-rp.second) *    cp.second;
+	  mWeight[q][3][cell] = (1-rp.second) * (1-cp.second);
+	}
+      }
+    }
+  }
+}
+
+
+//  A destination cell keeps its own values and (at most) four source cells in cache, so
+//  use half of L2 for that.  Bands are kept short so that there are plenty of tiles to
+//  spread over threads.
+
+void
+TransitionStencil::make_tiles (long cacheBytes, int valueBytes)
+{
+  const int maxTileRows (16);
+  if (cacheBytes <= 0)
+  { cacheBytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (cacheBytes <= 0) cacheBytes = 256 * 1024;
+  }
+  const long bytesPerCell ( 5 * ValuePlanes::nPlanes * valueBytes );
+  const long tileCells    ( std::max(256L, cacheBytes / 2 / bytesPerCell) );
+  const int  tileCols     ( (int) std::min((long) mCols-1, tileCells / maxTileRows) );
+  int first (0);
+  for (int r0=0; r0<mRows-1; r0 += maxTileRows)
+  { int r1 (std::min(r0+maxTileRows, mRows-1));
+    for (int c0=0; c0<mCols-1; c0 += tileCols)
+    { int c1 (std::min(c0+tileCols, mCols-1));
+      Tile t = { r0, r1, c0, c1, first };
+      mTiles.push_back(t);
+      first += (r1-r0)*(c1-c0);
+    }
+  }
+}
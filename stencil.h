@@ -0,0 +1,114 @@
+#ifndef _STENCIL_H_
+#define _STENCIL_H_
+
+#include "wealth.h"
+#include "value_planes.h"
+
+#include <vector>
+
+/***********************************************************************************
+
+  Transition stencil for a pair of dual wealth arrays (rows, columns).
+
+  The positions reached by bidding or rejecting, and the bilinear weights used
+  to interpolate the values at them, do not change from round to round.  The
+  stencil compiles them once into flat arrays, one entry per cell.
+
+  For each of the four neighbourhoods
+        00  neither rejects     01  only column rejects
+        10  only row rejects    11  both reject
+  a cell holds the offset of the upper-left source cell in ValuePlanes and the
+  four products of the row and column shares, so that
+        value = w0*V(r,c) + w1*V(r,c+1) + w2*V(r+1,c) + w3*V(r+1,c+1).
+
+  Cells are visited in tiles sized so that a tile's values and the (up to)
+  four separate regions it reads stay in L2 together.  The reject positions are
+  far from the bid positions when omega is large, so a tile reads four source
+  footprints rather than one.  Stencil entries are stored in the same tiled
+  order, so the stencil itself streams through memory.
+
+  The stencil depends only on the wealth arrays, so a solve for several
+  angles gathers from the planes of every angle with one pass over it.
+
+***********************************************************************************/
+
+class TransitionStencil
+{
+ public:
+  struct Tile { int r0, r1, c0, c1, firstCell; };          // rows [r0,r1), cols [c0,c1)
+
+ private:
+  const int mRows, mCols;                                  // rows, cols of value planes (with padding)
+  const int mStride;                                       // elements between rows in ValuePlanes
+  std::vector<Tile>   mTiles;
+  std::vector<double> mRowBid, mColBid;
+  std::vector<int>    mOffset[4];                          // by neighbourhood
+  std::vector<double> mWeight[4][4];                       // by neighbourhood, then corner
+
+ public:
+
+  // tiles are sized for values of valueBytes each; cacheBytes 0 = L2 size
+  TransitionStencil (DualWealthArray const& rowWealth, DualWealthArray const& colWealth, long cacheBytes = 0, int valueBytes = sizeof(float));
+
+  int    number_of_cells()       const { return (mRows-1)*(mCols-1); }
+  int    rows()                  const { return mRows; }
+  int    cols()                  const { return mCols; }
+
+  std::vector<Tile> const& tiles() const { return mTiles; }
+
+  double row_bid (int r)         const { return mRowBid[r]; }
+  double col_bid (int c)         const { return mColBid[c]; }
+
+  // v holds utility v00..v11, then row v00..v11, then col v00..v11 for a cell (in tile order),
+  // each the sum of four weighted values accumulated in type Acc
+  template <class Acc = double, class Scalar>
+  void   gather (int cell, BasicValuePlanes<Scalar> const& src, double v[12]) const;
+
+  // same for n sources that share the stencil (one per angle); v holds 12 values for each in turn
+  template <class Acc = double, class Scalar>
+  void   gather (int cell, int n, BasicValuePlanes<Scalar> const* const* src, double *v) const;
+
+ private:
+  void   make_tiles (long cacheBytes, int valueBytes);
+};
+
+
+template <class Acc, class Scalar>
+inline
+void
+TransitionStencil::gather (int cell, BasicValuePlanes<Scalar> const& src, double v[12]) const
+{
+  Scalar const* data (src.data());
+  for (int q=0; q<4; ++q)
+  { Scalar const* p0 (data + mOffset[q][cell]);                   // row r
+    Scalar const* p1 (p0 + mStride);                               //     r+1
+    const Acc w0 (mWeight[q][0][cell]), w1 (mWeight[q][1][cell]), w2 (mWeight[q][2][cell]), w3 (mWeight[q][3][cell]);
+    const int n  (ValuePlanes::nPlanes);
+    v[q  ] = w0*p0[ValuePlanes::utility] + w1*p0[n+ValuePlanes::utility] + w2*p1[ValuePlanes::utility] + w3*p1[n+ValuePlanes::utility];
+    v[q+4] = w0*p0[ValuePlanes::row    ] + w1*p0[n+ValuePlanes::row    ] + w2*p1[ValuePlanes::row    ] + w3*p1[n+ValuePlanes::row    ];
+    v[q+8] = w0*p0[ValuePlanes::col    ] + w1*p0[n+ValuePlanes::col    ] + w2*p1[ValuePlanes::col    ] + w3*p1[n+ValuePlanes::col    ];
+  }
+}
+
+
+template <class Acc, class Scalar>
+inline
+void
+TransitionStencil::gather (int cell, int n, BasicValuePlanes<Scalar> const* const* src, double *v) const
+{
+  const int m (ValuePlanes::nPlanes);
+  for (int q=0; q<4; ++q)
+  { const int offset (mOffset[q][cell]);                            // load the stencil once for all sources
+    const Acc w0 (mWeight[q][0][cell]), w1 (mWeight[q][1][cell]), w2 (mWeight[q][2][cell]), w3 (mWeight[q][3][cell]);
+    for (int i=0; i<n; ++i)
+    { Scalar const* p0 (src[i]->data() + offset);
+      Scalar const* p1 (p0 + mStride);
+      double *vi (v + 12*i);
+      vi[q  ] = w0*p0[ValuePlanes::utility] + w1*p0[m+ValuePlanes::utility] + w2*p1[ValuePlanes::utility] + w3*p1[m+ValuePlanes::utility];
+      vi[q+4] = w0*p0[ValuePlanes::row    ] + w1*p0[m+ValuePlanes::row    ] + w2*p1[ValuePlanes::row    ] + w3*p1[m+ValuePlanes::row    ];
+      vi[q+8] = w0*p0[ValuePlanes::col    ] + w1*p0[m+ValuePlanes::col    ] + w2*p1[ValuePlanes::col    ] + w3*p1[m+ValuePlanes::col    ];
+    }
+  }
+}
+
+#endif
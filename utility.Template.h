@@ -1,5 +1,10 @@
+#ifndef UTILITY_TEMPLATE_H
+#define UTILITY_TEMPLATE_H
+
 #include "utility.h"
 
+#include <algorithm>
+
 // -------------------------------------------------------------------------------------------------------------
 
 //   RejectMatrixUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     
@@ -46,6 +51,46 @@ RejectMatrixUtility<C>::col_utility (double mu, double v00, double v01, double v
 }
 
 
+template<class C>
+Derivatives
+RejectMatrixUtility<C>::derivatives (double mu) const
+{
+  const Derivatives none = { 0.0, 0.0, 0.0 };
+  return curve_weights()(reject_prob_derivatives(mu,mAlpha,mZAlpha), reject_prob_derivatives(mu,mBeta,mZBeta), none, none);
+}
+
+
+template <class C>
+CurveWeights
+RejectMatrixUtility<C>::curve_weights () const
+{
+  CurveWeights w (continuation_weights(mV00, mV01, mV10, mV11));
+  const double c0 (mCriterion(0.0,0.0));
+  w.constant  += c0;
+  w.probAlpha += mCriterion(1.0,0.0) - c0;
+  w.probBeta  += mCriterion(0.0,1.0) - c0;
+  return w;
+}
+
+template <class C>
+CurveWeights
+RejectMatrixUtility<C>::row_weights (double v00, double v01, double v10, double v11) const
+{
+  CurveWeights w (continuation_weights(v00, v01, v10, v11));
+  w.probAlpha += 1.0;
+  return w;
+}
+
+template <class C>
+CurveWeights
+RejectMatrixUtility<C>::col_weights (double v00, double v01, double v10, double v11) const
+{
+  CurveWeights w (continuation_weights(v00, v01, v10, v11));
+  w.probBeta += 1.0;
+  return w;
+}
+
+
 template <class C>
 void
 RejectMatrixUtility<C>::write_details_to_stream(double mu, std::ostream& os) const
@@ -71,7 +116,7 @@ RiskMatrixUtility<C>::operator()(double mu) const
   std::pair<double,double>  rprob  (MatrixUtility::reject_probabilities(mu));
   double rAlpha (rprob.first );
   double rBeta  (rprob.second);
-  double util   (mCriterion(risk(mu,MatrixUtility::mAlpha),risk(mu,MatrixUtility::mBeta)));
+  double util   (mCriterion(risk(mu,MatrixUtility::mAlpha,MatrixUtility::mZAlpha),risk(mu,MatrixUtility::mBeta,MatrixUtility::mZBeta)));
   if (rAlpha > rBeta)
     return  util + MatrixUtility::mV00 * (1-rAlpha) + MatrixUtility::mV10 * (rAlpha-rBeta) +  MatrixUtility::mV11 * rBeta;
   else
@@ -86,7 +131,7 @@ RiskMatrixUtility<C>::row_utility  (double mu, double v00, double v01, double v1
   std::pair<double,double>  rprob  (reject_probabilities(mu));
   double rAlpha (rprob.first );
   double rBeta  (rprob.second);
-  double util (risk(mu,mAlpha));
+  double util (risk(mu,mAlpha,mZAlpha));
   if (rAlpha > rBeta)
     return  util  + v00 * (1-rAlpha) + v10 * (rAlpha-rBeta) +  v11 * rBeta;
   else
@@ -101,13 +146,54 @@ RiskMatrixUtility<C>::col_utility (double mu, double v00, double v01, double v10
   std::pair<double,double>  rprob  (reject_probabilities(mu));
   double rAlpha (rprob.first);
   double rBeta (rprob.second);
-  double util  (risk(mu,mBeta));
+  double util  (risk(mu,mBeta,mZBeta));
   if (rAlpha > rBeta)
     return  util  + v00 * (1-rAlpha) + v10 * (rAlpha-rBeta) +  v11 * rBeta;
   else
     return  util  + v00 * (1- rBeta) + v01 * (rBeta-rAlpha) +  v11 * rAlpha;
 }
 
+template<class C>
+Derivatives
+RiskMatrixUtility<C>::derivatives (double mu) const
+{
+  const double alpha (MatrixUtility::mAlpha), beta (MatrixUtility::mBeta);
+  const double zAlpha (MatrixUtility::mZAlpha), zBeta (MatrixUtility::mZBeta);
+  return curve_weights()(reject_prob_derivatives(mu,alpha,zAlpha), reject_prob_derivatives(mu,beta,zBeta),
+			 risk_derivatives(mu,alpha,zAlpha), risk_derivatives(mu,beta,zBeta));
+}
+
+
+template <class C>
+CurveWeights
+RiskMatrixUtility<C>::curve_weights () const
+{
+  CurveWeights w (MatrixUtility::continuation_weights(MatrixUtility::mV00, MatrixUtility::mV01, MatrixUtility::mV10, MatrixUtility::mV11));
+  const double c0 (mCriterion(0.0,0.0));
+  w.constant  += c0;
+  w.riskAlpha += mCriterion(1.0,0.0) - c0;
+  w.riskBeta  += mCriterion(0.0,1.0) - c0;
+  return w;
+}
+
+template <class C>
+CurveWeights
+RiskMatrixUtility<C>::row_weights (double v00, double v01, double v10, double v11) const
+{
+  CurveWeights w (MatrixUtility::continuation_weights(v00, v01, v10, v11));
+  w.riskAlpha += 1.0;
+  return w;
+}
+
+template <class C>
+CurveWeights
+RiskMatrixUtility<C>::col_weights (double v00, double v01, double v10, double v11) const
+{
+  CurveWeights w (MatrixUtility::continuation_weights(v00, v01, v10, v11));
+  w.riskBeta += 1.0;
+  return w;
+}
+
 template <class C>
 void
 RiskMatrixUtility<C>::write_details_to_stream(double mu, std::ostream& os) const
@@ -121,3 +207,142 @@ RiskMatrixUtility<C>::write_details_to_stream(double mu, std::ostream& os) const
     //     << " V00=" << mV00 << "  V10=" << mV10 << " V01=" << mV01 << " V11=" << mV11;
 }
 
+
+
+// -------------------------------------------------------------------------------------------------------------
+
+//   RejectVectorUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     
+
+template <class C>
+double
+BasicRejectVectorUtility<C>::operator()(double mu) const
+{
+  std::pair<double,double>  rprob  (reject_probabilities(mu));
+  double rb (rprob.second);
+  return mCriterion(rprob.first, rb) + rb * mRejectValue + (1-rb) * mNoRejectValue;
+}
+
+template <class C>
+Derivatives
+BasicRejectVectorUtility<C>::derivatives (double mu) const
+{
+  Derivatives ra (reject_prob_derivatives(mu, mAlpha, mZAlpha));
+  Derivatives rb (reject_prob_derivatives(mu, mBeta , mZBeta ));
+  const double wb (mCy + mRejectValue - mNoRejectValue);
+  Derivatives d;
+  d.value  = mCx*ra.value  + wb*rb.value + mNoRejectValue + mC0;
+  d.first  = mCx*ra.first  + wb*rb.first;
+  d.second = mCx*ra.second + wb*rb.second;
+  return d;
+}
+
+template <class C>
+void
+BasicRejectVectorUtility<C>::evaluate (VectorLanes const& lanes, double const* mu, double *util) const
+{
+  double ra[VectorLanes::batch], rb[VectorLanes::batch];
+  for (int i0=0; i0<lanes.n; i0+=VectorLanes::batch)
+  { const int m (std::min(VectorLanes::batch, lanes.n-i0));
+    reject_probs_and_risks(m, mu+i0, &mAlpha, &mZAlpha, 0, ra, 0);
+    reject_probs_and_risks(m, mu+i0, lanes.beta+i0, lanes.zBeta+i0, 1, rb, 0);
+    for (int i=0; i<m; ++i)
+      util[i0+i] = mCriterion(ra[i], rb[i]) + rb[i] * lanes.rejectValue[i0+i] + (1-rb[i]) * lanes.noRejectValue[i0+i];
+  }
+}
+
+template <class C>
+bool
+BasicRejectVectorUtility<C>::curve_weights (CurveWeights &w) const
+{
+  CurveWeights cw = { mNoRejectValue + mC0, mCx, mCy + mRejectValue - mNoRejectValue, 0.0, 0.0 };
+  w = cw;
+  return true;
+}
+
+template <class C>
+double
+BasicRejectVectorUtility<C>::bidder_utility (double mu, double rejectValue, double noRejectValue) const
+{
+  double rb (r_mu_beta(mu));
+  return rb  + rb * rejectValue + (1-rb) * noRejectValue;
+}
+
+template <class C>
+double
+BasicRejectVectorUtility<C>::oracle_utility (double mu, double rejectValue, double noRejectValue) const
+{
+  std::pair<double,double>  rejectProbs  (reject_probabilities(mu));
+  double rb (rejectProbs.second);                                          
+  return rejectProbs.first + rb * rejectValue + (1-rb) * noRejectValue;
+}
+
+
+//    RiskVectorUtility      RiskUtility      RiskUtility      RiskUtility      RiskUtility      RiskUtility
+
+template <class Oracle, class C>
+double
+BasicRiskVectorUtility<Oracle,C>::operator()(double mu) const
+{
+  double rb    (r_mu_beta(mu));
+  return  mCriterion(mOracle.risk(mu), risk(mu, mBeta, mZBeta)) + rb * mRejectValue + (1-rb) * mNoRejectValue;
+}
+
+template <class Oracle, class C>
+Derivatives
+BasicRiskVectorUtility<Oracle,C>::derivatives (double mu) const
+{
+  Derivatives oracle (mOracle.derivatives(mu));
+  Derivatives bidder (risk_derivatives(mu, mBeta, mZBeta));
+  Derivatives rb     (reject_prob_derivatives(mu, mBeta, mZBeta));
+  const double dv (mRejectValue - mNoRejectValue);
+  Derivatives d;
+  d.value  = mCx*oracle.value  + mCy*bidder.value  + dv*rb.value + mNoRejectValue + mC0;
+  d.first  = mCx*oracle.first  + mCy*bidder.first  + dv*rb.first;
+  d.second = mCx*oracle.second + mCy*bidder.second + dv*rb.second;
+  return d;
+}
+
+template <class Oracle, class C>
+void
+BasicRiskVectorUtility<Oracle,C>::evaluate (VectorLanes const& lanes, double const* mu, double *util) const
+{
+  double oracle[VectorLanes::batch], rb[VectorLanes::batch], bidder[VectorLanes::batch];
+  for (int i0=0; i0<lanes.n; i0+=VectorLanes::batch)
+  { const int m (std::min(VectorLanes::batch, lanes.n-i0));
+    mOracle.risks(m, mu+i0, oracle);
+    reject_probs_and_risks(m, mu+i0, lanes.beta+i0, lanes.zBeta+i0, 1, rb, bidder);
+    for (int i=0; i<m; ++i)
+    { const double r ((0.0 == mu[i0+i]) ? lanes.beta[i0+i] : rb[i]);
+      util[i0+i] = mCriterion(oracle[i], bidder[i]) + r * lanes.rejectValue[i0+i] + (1-r) * lanes.noRejectValue[i0+i];
+    }
+  }
+}
+
+template <class Oracle, class C>
+bool
+BasicRiskVectorUtility<Oracle,C>::curve_weights (CurveWeights &w) const
+{
+  CurveWeights cw = { mNoRejectValue + mC0, 0.0, mRejectValue - mNoRejectValue, 0.0, mCy };
+  if (!mOracle.add_curve(mCx, cw))                                 // risk inflation oracle is not one of the curves
+    return false;
+  w = cw;
+  return true;
+}
+
+template <class Oracle, class C>
+double
+BasicRiskVectorUtility<Oracle,C>::oracle_utility (double mu, double rejectValue, double noRejectValue) const 
+{
+  double rb (r_mu_beta(mu));
+  return  mOracle.risk(mu) + rb * rejectValue + (1-rb) * noRejectValue;
+}
+
+template <class Oracle, class C>
+double
+BasicRiskVectorUtility<Oracle,C>::bidder_utility (double mu, double rejectValue, double noRejectValue) const
+{
+  double rb (r_mu_beta(mu));
+  return  risk(mu, mBeta, mZBeta)  + rb * rejectValue + (1-rb) * noRejectValue;
+}
+
+#endif
@@ -1,11 +1,13 @@
-#include "utility.h"
+#include "utility.Template.h"
 
-#include "normal.h"
+#include "special_functions.h"
 
 #include <utility> // pair
+#include <algorithm>
+#include <atomic>
 
 const std::string messageTag ("UTIL: ");
-      int         messageCnt (0);
+std::atomic<int>  messageCnt (0);                      // warnings so far, from any thread
 const int         messageLim (2);
 
 ////////////////////////////////////  Utility functions  /////////////////////////////////////////
@@ -16,6 +18,15 @@ static const double epsilon  = 1.0e-15;
 
 double
 reject_prob(double mu, double alpha)    // r_mu(alpha)
+{
+  if(alpha < epsilon)
+    return 0.0;
+  else
+    return reject_prob(mu, alpha, z_alpha(alpha/2));   // two sided
+}
+
+double
+reject_prob(double mu, double alpha, double z)
 {
   if(alpha < epsilon)
     return 0.0;
@@ -23,12 +34,34 @@ reject_prob(double mu, double alpha)    // r_mu(alpha)
   { if (fabs(mu) < epsilon)
       return alpha;
     else
-    { double z = z_alpha(alpha/2);   // two sided
-      return normal_cdf(mu-z) + normal_cdf(-mu-z);
-    }
+      return Special::cdf(mu-z) + Special::cdf(-mu-z);
   }
 }
 
+//  r(mu) = Phi(mu-z) + Phi(-mu-z), so with dev = z-mu and sum = z+mu
+//     r'  = phi(dev) - phi(sum),    r'' = dev phi(dev) + sum phi(sum)
+
+Derivatives
+reject_prob_derivatives (double mu, double alpha)
+{
+  return reject_prob_derivatives(mu, alpha, z_alpha(alpha/2));
+}
+
+Derivatives
+reject_prob_derivatives (double mu, double alpha, double z)
+{
+  Derivatives d = { 0.0, 0.0, 0.0 };
+  if (alpha < epsilon)
+    return d;
+  double dev = z - mu;
+  double sum = z + mu;
+  double pDev (Special::density(dev)), pSum (Special::density(sum));
+  d.value  = (fabs(mu) < epsilon) ? alpha : Special::cdf(-dev) + Special::cdf(-sum);
+  d.first  = pDev - pSum;
+  d.second = dev * pDev + sum * pSum;
+  return d;
+}
+
 double
 reject_value(int i, WIndex const& kp, Matrix const& value, bool show)
 {
@@ -69,8 +102,10 @@ z_alpha (double alpha)
 {
   if (alpha < epsilon)
     return maximumZ;
+  else if (Special::exact == Special::accuracy())
+    return Special::quantile(1-alpha);
   else
-    return normal_quantile(1-alpha);
+    return -Special::quantile(alpha);                  // lower tail, without rounding 1-alpha
 }
 
 // used in expert competitive alpha
@@ -80,7 +115,7 @@ optimal_alpha (double mu, double omega)
     return 0.0;
   else
     { double z = (mu * mu + 2 * log(1.0/omega))/(2 * mu);
-      return 1.0 - normal_cdf(z);
+      return 1.0 - Special::cdf(z);
     }
 }
 
@@ -91,14 +126,106 @@ risk(double mu, double alpha)
   if (0 == alpha)
     return mu*mu;          // ras 5/5/13
   else
-  { double z_a = z_alpha(alpha/2);
-    if (fabs(mu) < epsilon)
-      return  2 * (z_a * normal_density(z_a) + normal_cdf(-z_a));
+    return risk(mu, alpha, z_alpha(alpha/2));
+}
+
+double
+risk(double mu, double alpha, double z_a)
+{
+  if (0 == alpha)
+    return mu*mu;
+  else
+  { if (fabs(mu) < epsilon)
+      return  2 * (z_a * Special::density(z_a) + Special::cdf(-z_a));
     else
-    { double R = (1.0 - reject_prob(mu, alpha)) * mu * mu;
+    { double R = (1.0 - reject_prob(mu, alpha, z_a)) * mu * mu;
       double dev = z_a - mu;
       double sum = z_a + mu;   // two-sided
-      return R + dev * normal_density(dev) + normal_cdf(-dev) + sum * normal_density(sum) + normal_cdf(-sum);
+      return R + dev * Special::density(dev) + Special::cdf(-dev) + sum * Special::density(sum) + Special::cdf(-sum);
+    }
+  }
+}
+
+
+//  risk(mu) = (1-r) mu^2 + g(dev) + g(sum) with g(x) = x phi(x) + Phi(-x) and g'(x) = -x^2 phi(x), so
+//     risk'  = phi(dev)(z^2-2 z mu) - phi(sum)(z^2+2 z mu) + 2(1-r) mu
+//     risk'' = dev phi(dev)(z^2-2 z mu) + sum phi(sum)(z^2+2 z mu) - 2 z (phi(dev)+phi(sum)) - 2 r' mu + 2(1-r)
+
+Derivatives
+risk_derivatives (double mu, double alpha)
+{
+  return risk_derivatives(mu, alpha, (0 == alpha) ? 0.0 : z_alpha(alpha/2));
+}
+
+Derivatives
+risk_derivatives (double mu, double alpha, double z)
+{
+  Derivatives d;
+  if (0 == alpha)
+  { d.value = mu*mu; d.first = 2*mu; d.second = 2.0;
+    return d;
+  }
+  double dev = z - mu;
+  double sum = z + mu;
+  double pDev (Special::density(dev)), pSum (Special::density(sum));
+  double r   = (fabs(mu) < epsilon) ? alpha : Special::cdf(-dev) + Special::cdf(-sum);
+  double dr  = pDev - pSum;
+  double aDev (z*z - 2*z*mu), aSum (z*z + 2*z*mu);
+  d.value  = (1.0 - r) * mu * mu + dev * pDev + Special::cdf(-dev) + sum * pSum + Special::cdf(-sum);
+  d.first  = pDev * aDev - pSum * aSum + 2 * (1.0 - r) * mu;
+  d.second = dev * pDev * aDev + sum * pSum * aSum - 2 * z * (pDev + pSum) - 2 * dr * mu + 2 * (1.0 - r);
+  return d;
+}
+
+
+//  With g(x) = x phi(x) + Phi(-x) decreasing, g(z-mu) increases and g(z+mu) decreases in mu,
+//  as does 1-r, so each piece of risk is bounded by its values at the ends of [a,b].
+
+std::pair<double,double>
+risk_bounds (double a, double b, double alpha)
+{
+  if (0 == alpha)
+    return std::make_pair(a*a, b*b);
+  double z = z_alpha(alpha/2);
+  double ra (reject_prob(a, alpha, z)), rb (reject_prob(b, alpha, z));
+  double gDevA ((z-a) * Special::density(z-a) + Special::cdf(a-z)), gDevB ((z-b) * Special::density(z-b) + Special::cdf(b-z));
+  double gSumA ((z+a) * Special::density(z+a) + Special::cdf(-z-a)), gSumB ((z+b) * Special::density(z+b) + Special::cdf(-z-b));
+  return std::make_pair((1.0 - rb) * a * a + gDevA + gSumB,
+			(1.0 - ra) * b * b + gDevB + gSumA);
+}
+
+
+//  The same arithmetic as reject_prob and risk, with the normal cdf and density of mu-z and
+//  -mu-z for a chunk of means found in one batch call each.  Since phi is even and
+//  Phi(-dev) = Phi(mu-z), the risk needs no further arguments.
+
+void
+reject_probs_and_risks (int n, double const* mu, double const* level, double const* z, int stride,
+			double *probs, double *risks)
+{
+  const int chunk (32);
+  double arg[2*chunk], cdf[2*chunk], pdf[2*chunk];
+  for (int i0=0; i0<n; i0+=chunk)
+  { const int m (std::min(chunk, n-i0));
+    for (int i=0; i<m; ++i)
+    { const double zi (z[(i0+i)*stride]);
+      arg[2*i  ] =  mu[i0+i] - zi;
+      arg[2*i+1] = -mu[i0+i] - zi;
+    }
+    Special::cdf(2*m, arg, cdf, Special::accuracy());
+    if (risks)
+      Special::density(2*m, arg, pdf, Special::accuracy());
+    for (int i=0; i<m; ++i)
+    { const double x (mu[i0+i]), alpha (level[(i0+i)*stride]), zi (z[(i0+i)*stride]);
+      const double r ((alpha < epsilon) ? 0.0 : ((fabs(x) < epsilon) ? alpha : cdf[2*i] + cdf[2*i+1]));
+      probs[i0+i] = r;
+      if (!risks) continue;
+      if (0 == alpha)
+	risks[i0+i] = x*x;
+      else if (fabs(x) < epsilon)
+	risks[i0+i] = risk(x, alpha, zi);
+      else
+	risks[i0+i] = (1.0 - r) * x * x + (zi - x) * pdf[2*i] + cdf[2*i] + (zi + x) * pdf[2*i+1] + cdf[2*i+1];
     }
   }
 }
@@ -111,12 +238,13 @@ void
 VectorUtility::set_constants (double beta, double rejectValue, double noRejectValue)
 { assert (0 <= beta);
   if (beta >= 1.0)
-  { ++messageCnt;
-    if (messageCnt == messageLim) std::cerr << messageTag << "Message limit reached." << std::endl;
-    if (messageCnt < messageLim) std::cerr << messageTag << "* Warning *  Bid beta too large; reduced to 0.99" << std::endl;
+  { const int count (++messageCnt);
+    if (count == messageLim) std::cerr << messageTag << "Message limit reached." << std::endl;
+    if (count < messageLim) std::cerr << messageTag << "* Warning *  Bid beta too large; reduced to 0.99" << std::endl;
     beta = 0.99;
   }
   mBeta = beta;
+  mZBeta = z_alpha(beta/2);
   mRejectValue = rejectValue;
   mNoRejectValue = noRejectValue;
 }
@@ -124,13 +252,13 @@ VectorUtility::set_constants (double beta, double rejectValue, double noRejectVa
 double
 VectorUtility::r_mu_beta (double mu) const
 {
-  return (0.0 == mu) ? mBeta : reject_prob(mu, mBeta);
+  return (0.0 == mu) ? mBeta : reject_prob(mu, mBeta, mZBeta);
 }
 
 double
 VectorUtility::r_mu_alpha (double mu) const
 {
-  return (0.0 == mu) ? mAlpha : reject_prob(mu, mAlpha);
+  return (0.0 == mu) ? mAlpha : reject_prob(mu, mAlpha, mZAlpha);
 }
 
 std::pair<double,double>
@@ -142,99 +270,29 @@ VectorUtility::reject_probabilities (double mu) const
     rb = mBeta;
   }
   else
-  { ra = reject_prob(mu,mAlpha);
-    rb = reject_prob(mu,mBeta );
+  { ra = reject_prob(mu, mAlpha, mZAlpha);
+    rb = reject_prob(mu, mBeta , mZBeta );
   }
   return std::make_pair(ra,rb);
 }  
 
-//   RejectUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     RejectUtility     
-
-double
-RejectVectorUtility::operator()(double mu) const
-{
-  std::pair<double,double>  rprob  (reject_probabilities(mu));
-  double rb (rprob.second);
-  return mCos*rprob.first + mSin*rb  + rb * mRejectValue + (1-rb) * mNoRejectValue;
-}
-
-double
-RejectVectorUtility::bidder_utility (double mu, double rejectValue, double noRejectValue) const
-{
-  double rb (r_mu_beta(mu));
-  return rb  + rb * rejectValue + (1-rb) * noRejectValue;
-}
-
-double
-RejectVectorUtility::oracle_utility (double mu, double rejectValue, double noRejectValue) const
-{
-  std::pair<double,double>  rejectProbs  (reject_probabilities(mu));
-  double rb (rejectProbs.second);                                          
-  return rejectProbs.first + rb * rejectValue + (1-rb) * noRejectValue;
-}
-
-
-//    RiskUtility      RiskUtility      RiskUtility      RiskUtility      RiskUtility      RiskUtility      RiskUtility
+//   Vector utilities at an angle     Vector utilities at an angle     Vector utilities at an angle
 
+template class BasicRejectVectorUtility<AngleCriterion>;
+template class BasicRiskVectorUtility<LevelOracle,         AngleCriterion>;
+template class BasicRiskVectorUtility<LeastSquaresOracle,  AngleCriterion>;
+template class BasicRiskVectorUtility<RiskInflationOracle, AngleCriterion>;
+template class BasicRiskVectorUtility<TestimatorOracle,    AngleCriterion>;
 
-double
-least_squares_oracle_risk(double mu)   { return (mu == 0.0)?     0.0  : 1.0; }
-
-double
-risk_inflation_oracle_risk(double mu)  { return (mu  < 1.0)?  (mu*mu) : 1.0; }
-
-double _testimatorAlphaLevel_ = 0.05;
-
-double
-testimator_risk(double mu)             { return risk(mu,_testimatorAlphaLevel_); }
-
-
-
-////
-
-void
-RiskVectorUtility::set_oracle_risk ()
-{
-  if (0 == mAlpha)
-    mOracleRisk = least_squares_oracle_risk;
-  else if (1 == mAlpha)
-    mOracleRisk = risk_inflation_oracle_risk;
-  else
-  { _testimatorAlphaLevel_ = mAlpha;
-    mOracleRisk = testimator_risk;
-  }
-}
-
-void
-RiskVectorUtility::print_type() const
+VectorUtility*
+make_risk_vector_utility (double angle, double alpha)
 {
-  if (0 == mAlpha)
-    std::clog << "UTIL: Least squares oracle" << std::endl;
-  else if (1 == mAlpha)
-    std::clog << "UTIL: Risk-inflation oracle" << std::endl;
+  if (0 == alpha)
+    return new BasicRiskVectorUtility<LeastSquaresOracle,  AngleCriterion>(angle, alpha);
+  else if (1 == alpha)
+    return new BasicRiskVectorUtility<RiskInflationOracle, AngleCriterion>(angle, alpha);
   else
-    std::clog << "UTIL: Testimator oracle with alpha= " << mAlpha << std::endl;
-}
-
-double
-RiskVectorUtility::operator()(double mu) const
-{
-  double rb    (r_mu_beta(mu));
-  return  mCos*mOracleRisk(mu) + mSin*risk(mu,mBeta) + rb * mRejectValue + (1-rb) * mNoRejectValue;
-}
-
-double
-RiskVectorUtility::oracle_utility (double mu, double rejectValue, double noRejectValue) const 
-{
-  double rb (r_mu_beta(mu));
-  return  mOracleRisk(mu) + rb * rejectValue + (1-rb) * noRejectValue;
-}
-
-double
-RiskVectorUtility::bidder_utility (double mu, double rejectValue, double noRejectValue) const
-{
-  double rb (r_mu_beta(mu));
-  return  risk(mu,mBeta)  + rb * rejectValue + (1-rb) * noRejectValue;
+    return new BasicRiskVectorUtility<TestimatorOracle,    AngleCriterion>(angle, alpha);
 }
 
 
@@ -249,6 +307,8 @@ MatrixUtility::set_constants (double alpha, double beta, double v00, double v01,
   assert((0 <=  beta) && ( beta <= 1.0));
   mAlpha=alpha;
   mBeta = beta;
+  mZAlpha = z_alpha(alpha/2);
+  mZBeta  = z_alpha(beta/2);
   mV00 = v00; mV01 = v01; mV10 = v10; mV11 = v11;
 }
 
@@ -281,6 +341,22 @@ MatrixUtility::r_mu_beta (double mu) const
 }
 
 
+CurveWeights
+MatrixUtility::continuation_weights (double v00, double v01, double v10, double v11) const
+{
+  CurveWeights w = { v00, 0.0, 0.0, 0.0, 0.0 };
+  if (mAlpha > mBeta)                                                  // then rAlpha > rBeta at every mu
+  { w.probAlpha = v10 - v00;
+    w.probBeta  = v11 - v10;
+  }
+  else
+  { w.probAlpha = v11 - v01;
+    w.probBeta  = v01 - v00;
+  }
+  return w;
+}
+
+
 std::pair<double,double>
 MatrixUtility::reject_probabilities (double mu) const
 {
@@ -290,8 +366,8 @@ MatrixUtility::reject_probabilities (double mu) const
     rb = mBeta;
   }
   else
-  { ra = (0.0 == mAlpha) ? 0.0 : reject_prob(mu,mAlpha);
-    rb = (0.0 == mBeta ) ? 0.0 : reject_prob(mu,mBeta );
+  { ra = (0.0 == mAlpha) ? 0.0 : reject_prob(mu, mAlpha, mZAlpha);
+    rb = (0.0 == mBeta ) ? 0.0 : reject_prob(mu, mBeta , mZBeta );
   }
   return std::make_pair(ra,rb);
 }  
@@ -10,6 +10,7 @@
 #include <math.h>
 #include <assert.h>
 #include <iostream>      // debug
+#include <sstream>
 
 
 typedef Eigen::MatrixXf Matrix;
@@ -19,6 +20,17 @@ typedef std::pair<int,double> WIndex;
 ////////////////////////////////////  Utility functions  /////////////////////////////////////////
 
 double   reject_prob(double mu, double level);
+double   reject_prob(double mu, double level, double z);      // z = z_alpha(level/2), for callers that keep it
+
+//  Value of a function of mu and its first two derivatives with respect to mu
+
+struct Derivatives
+{
+  double value, first, second;
+};
+
+Derivatives reject_prob_derivatives (double mu, double level);
+Derivatives reject_prob_derivatives (double mu, double level, double z);
 
 double   reject_value(   int i         , WIndex const& kp , Matrix const& value, bool show = false);
 double   reject_value(WIndex const& kp ,       int j      , Matrix const& value, bool show = false);
@@ -27,24 +39,74 @@ double   reject_value(WIndex const& kp1, WIndex const& kp2, Matrix const& value,
 double   z_alpha       (double a);
 
 double   risk          (double mu, double alpha); 
+double   risk          (double mu, double alpha, double z);   // z = z_alpha(alpha/2)
+
+Derivatives risk_derivatives (double mu, double alpha);
+Derivatives risk_derivatives (double mu, double alpha, double z);
+
+std::pair<double,double> risk_bounds (double a, double b, double alpha);   // lower, upper bound of risk(mu,alpha) for 0 <= a <= mu <= b
+
+//  reject_prob and risk (unless risks is null) of n means at level[i*stride] with z[i*stride] = z_alpha(level/2),
+//  computed in batches (stride 0 uses one level for all)
+void     reject_probs_and_risks (int n, double const* mu, double const* level, double const* z, int stride,
+				 double *probs, double *risks);
 
 double   optimal_alpha (double mu, double omega);
 
+//  Once the constants are set, a utility is a linear combination of the rejection
+//  probabilities and risks at alpha and beta, all functions of mu alone.  The weights let
+//  a solver evaluate or bound the utility from tables of these curves (criteria must be linear).
+
+struct CurveWeights
+{
+  double constant;
+  double probAlpha, probBeta;
+  double riskAlpha, riskBeta;
+
+  double operator()(double rAlpha, double rBeta, double riskAlpha_, double riskBeta_) const
+    { return constant + probAlpha*rAlpha + probBeta*rBeta + riskAlpha*riskAlpha_ + riskBeta*riskBeta_; }
+
+  Derivatives operator()(Derivatives const& rAlpha, Derivatives const& rBeta, Derivatives const& riskAlpha_, Derivatives const& riskBeta_) const
+    { Derivatives d;
+      d.value  = (*this)(rAlpha.value, rBeta.value, riskAlpha_.value, riskBeta_.value);
+      d.first  = probAlpha*rAlpha.first  + probBeta*rBeta.first  + riskAlpha*riskAlpha_.first  + riskBeta*riskBeta_.first;
+      d.second = probAlpha*rAlpha.second + probBeta*rBeta.second + riskAlpha*riskAlpha_.second + riskBeta*riskBeta_.second;
+      return d;
+    }
+};
+
+
 ////   Vector utility trades off between two possible values
 
+//  Constants of a batch of vector utilities that differ only in the bid beta and the
+//  continuation values, one lane for each wealth position (see LockstepSearch)
+
+struct VectorLanes
+{
+  static const int batch = 32;                       // lanes a utility evaluates together
+
+  int           n;
+  double const *beta, *zBeta;                        // zBeta = z_alpha(beta/2)
+  double const *rejectValue, *noRejectValue;
+
+  VectorLanes offset (int i, int count) const
+    { VectorLanes l = { count, beta+i, zBeta+i, rejectValue+i, noRejectValue+i }; return l; }
+};
+
 class VectorUtility: public std::unary_function<double,double>
 {
  protected:
-  const double mAngle, mSin, mCos;
+  const double mAngle;
   const double mAlpha;
-  double mBeta;
+  const double mZAlpha;                                  // z_alpha(mAlpha/2)
+  double mBeta, mZBeta;                                  // mZBeta = z_alpha(mBeta/2)
   double mRejectValue, mNoRejectValue;
   
  public:
 
  VectorUtility(double angle, double alphaLevel)
-   : mAngle(angle), mSin(sin(angle * 3.1415926536/180)), mCos(cos(angle * 3.1415926536/180)),
-    mAlpha(alphaLevel),  mBeta(0.0), mRejectValue(0.0), mNoRejectValue(0.0) { }
+   : mAngle(angle),
+    mAlpha(alphaLevel), mZAlpha(z_alpha(alphaLevel/2)), mBeta(0.0), mZBeta(0.0), mRejectValue(0.0), mNoRejectValue(0.0) { }
   
   double alpha      () const { return mAlpha; }
   double beta       () const { return mBeta;  }
@@ -60,6 +122,15 @@ class VectorUtility: public std::unary_function<double,double>
   virtual
     double operator()(double mu) const  { std::cout << "UTIL:  Call to operator of base class." << std::endl; return 0*mu; }
 
+  virtual
+    Derivatives derivatives (double mu) const = 0;                      // operator() and its derivatives
+
+  virtual                                                               // operator() for each lane at its mu
+    void evaluate (VectorLanes const& lanes, double const* mu, double *util) const = 0;
+
+  virtual                                                               // for mu > 0, alpha the oracle level; false if
+    bool curve_weights (CurveWeights &w) const = 0;                     //   not a combination of the curves
+
   virtual
     double bidder_utility (double mu, double rejectValue, double noRejectValue) const = 0;
   
@@ -70,85 +141,203 @@ class VectorUtility: public std::unary_function<double,double>
 
 
 
-////  RejectVectorUtility     Rejects     Rejects     Rejects     Rejects     Rejects     Rejects     
+//     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria
+
+class AngleCriterion:  public std::binary_function<double,double,double>
+{
+ private:
+  const double mAngle, mSin, mCos;
+
+ public:
+  AngleCriterion(double angle)
+    : mAngle(angle), mSin(sin(angle * 3.1415926536/180)), mCos(cos(angle * 3.1415926536/180)) { }
+
+  std::string identifier() const     { return std::to_string(mAngle); }
+
+  double operator()(double x, double y) const { return mCos*x + mSin*y; }
+};
 
-class RejectVectorUtility: public VectorUtility
 
+class RiskInflationCriterion:  public std::binary_function<double,double,double>
 {
+ private:
+  const double mB1;
+
  public:
+  RiskInflationCriterion(double b1)
+    : mB1(b1) { }
 
- RejectVectorUtility(double angle, double alpha)
-   : VectorUtility(angle, alpha) { }
+  std::string identifier() const     { return std::to_string((int)round(mB1)); }
 
-  double operator()(double mu) const;
+  double operator()(double x, double y) const { return x - mB1*y; }
+};
 
-  double bidder_utility (double mu, double rejectValue, double noRejectValue) const;
-  double oracle_utility (double mu, double rejectValue, double noRejectValue) const;
-  
-}; 
 
+//  The vector utilities below are templates on the criterion that weighs the oracle against
+//  the bidder (built from the angle), and the risk utility also on the risk of the oracle.  Their
+//  classes are final so that a solver handed one type calls it directly (and can inline it)
+//  rather than through VectorUtility.
 
-////  RiskVectorUtility     Risk     Risk     Risk     Risk     Risk     Risk     Risk     Risk     Risk
+////  Oracles     Oracles     Oracles     Oracles     Oracles     Oracles     Oracles     Oracles     Oracles
+
+//  Risk of the oracle at mu, given the level alpha of the oracle and z = z_alpha(alpha/2)
 
-class RiskVectorUtility: public VectorUtility
+class LeastSquaresOracle
 {
-  double (*mOracleRisk)(double);
-  
  public:
-  
- RiskVectorUtility(double angle, double alpha)
-   : VectorUtility(angle, alpha) { set_oracle_risk(); print_type(); }
-  
-  double operator()(double mu) const;
-  
-  double bidder_utility (double mu, double rejectValue, double noRejectValue) const;
-  double oracle_utility (double mu, double rejectValue, double noRejectValue) const;
+  LeastSquaresOracle (double, double) { }
 
- private:
-  void set_oracle_risk();
-  void print_type() const;
-  
+  std::string name()                                const { return "Least squares oracle"; }
+
+  double      risk (double mu)                      const { return (mu == 0.0) ? 0.0 : 1.0; }
+  Derivatives derivatives (double mu)               const { Derivatives d = { risk(mu), 0.0, 0.0 }; return d; }
+  void        risks (int n, double const* mu, double *r) const { for (int i=0; i<n; ++i) r[i] = risk(mu[i]); }
+
+  // adds weight times the risk as a combination of the curves for mu > 0; false if it is not one
+  bool        add_curve (double weight, CurveWeights &w) const { w.constant += weight; return true; }
 };
 
 
-//     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria     Criteria
+class RiskInflationOracle
+{
+ public:
+  RiskInflationOracle (double, double) { }
 
-class AngleCriterion:  public std::binary_function<double,double,double>
+  std::string name()                                const { return "Risk-inflation oracle"; }
+
+  double      risk (double mu)                      const { return (mu < 1.0) ? (mu*mu) : 1.0; }
+  Derivatives derivatives (double mu)               const
+    { Derivatives d = { 1.0, 0.0, 0.0 };
+      if (mu < 1.0) { d.value = mu*mu; d.first = 2*mu; d.second = 2.0; }
+      return d;
+    }
+  void        risks (int n, double const* mu, double *r) const { for (int i=0; i<n; ++i) r[i] = risk(mu[i]); }
+
+  bool        add_curve (double, CurveWeights &)    const { return false; }
+};
+
+
+class TestimatorOracle
 {
- private:
-  const double mAngle, mSin, mCos;
+  double mAlpha, mZ;
 
  public:
-  AngleCriterion(double angle)
-    : mAngle(angle), mSin(sin(angle * 3.1415926536/180)), mCos(cos(angle * 3.1415926536/180)) { }
+  TestimatorOracle (double alpha, double z) : mAlpha(alpha), mZ(z) { }
 
-  std::string identifier() const     { return std::to_string(mAngle); }
+  std::string name()                                const { std::ostringstream ss; ss << "Testimator oracle with alpha= " << mAlpha; return ss.str(); }
 
-  double operator()(double x, double y) const { return mCos*x + mSin*y; }
+  double      risk (double mu)                      const { return ::risk(mu, mAlpha, mZ); }
+  Derivatives derivatives (double mu)               const { return risk_derivatives(mu, mAlpha, mZ); }
+  void        risks (int n, double const* mu, double *r) const               // n at most VectorLanes::batch
+    { double probs[VectorLanes::batch];
+      reject_probs_and_risks(n, mu, &mAlpha, &mZ, 0, probs, r);
+    }
+
+  bool        add_curve (double weight, CurveWeights &w) const { w.riskAlpha += weight; return true; }
 };
 
 
-class RiskInflationCriterion:  public std::binary_function<double,double,double>
+//  Oracle chosen by its level when the utility is built: least squares for 0, risk inflation for 1,
+//  otherwise the testimator
+
+class LevelOracle
 {
- private:
-  const double mB1;
+  LeastSquaresOracle  mLeastSquares;
+  RiskInflationOracle mRiskInflation;
+  TestimatorOracle    mTestimator;
+  const int           mKind;                             // 0, 1, or 2 for the testimator
 
  public:
-  RiskInflationCriterion(double b1)
-    : mB1(b1) { }
+  LevelOracle (double alpha, double z)
+    : mLeastSquares(alpha, z), mRiskInflation(alpha, z), mTestimator(alpha, z), mKind((0 == alpha) ? 0 : ((1 == alpha) ? 1 : 2)) { }
+
+  std::string name()                                const
+    { return (0 == mKind) ? mLeastSquares.name() : ((1 == mKind) ? mRiskInflation.name() : mTestimator.name()); }
+
+  double      risk (double mu)                      const
+    { return (0 == mKind) ? mLeastSquares.risk(mu) : ((1 == mKind) ? mRiskInflation.risk(mu) : mTestimator.risk(mu)); }
+  Derivatives derivatives (double mu)               const
+    { return (0 == mKind) ? mLeastSquares.derivatives(mu) : ((1 == mKind) ? mRiskInflation.derivatives(mu) : mTestimator.derivatives(mu)); }
+  void        risks (int n, double const* mu, double *r) const
+    { if (2 == mKind) mTestimator.risks(n, mu, r);
+      else for (int i=0; i<n; ++i) r[i] = risk(mu[i]);
+    }
+
+  bool        add_curve (double weight, CurveWeights &w) const
+    { return (0 == mKind) ? mLeastSquares.add_curve(weight, w) : ((1 == mKind) ? mRiskInflation.add_curve(weight, w) : mTestimator.add_curve(weight, w)); }
+};
 
-  std::string identifier() const     { return std::to_string((int)round(mB1)); }
 
-  double operator()(double x, double y) const { return x - mB1*y; }
+////  RejectVectorUtility     Rejects     Rejects     Rejects     Rejects     Rejects     Rejects     
+
+template <class C>
+class BasicRejectVectorUtility final : public VectorUtility
+{
+  const C mCriterion;
+  const double mC0, mCx, mCy;                            // criterion is mC0 + mCx x + mCy y
+
+ public:
+
+ BasicRejectVectorUtility(double angle, double alpha)
+   : VectorUtility(angle, alpha), mCriterion(angle),
+    mC0(mCriterion(0.0,0.0)), mCx(mCriterion(1.0,0.0)-mC0), mCy(mCriterion(0.0,1.0)-mC0) { }
+
+  double operator()(double mu) const;
+  Derivatives derivatives (double mu) const;
+  void   evaluate (VectorLanes const& lanes, double const* mu, double *util) const;
+  bool   curve_weights (CurveWeights &w) const;
+
+  double bidder_utility (double mu, double rejectValue, double noRejectValue) const;
+  double oracle_utility (double mu, double rejectValue, double noRejectValue) const;
+  
+}; 
+
+
+////  RiskVectorUtility     Risk     Risk     Risk     Risk     Risk     Risk     Risk     Risk     Risk
+
+template <class Oracle, class C>
+class BasicRiskVectorUtility final : public VectorUtility
+{
+  const Oracle mOracle;
+  const C mCriterion;
+  const double mC0, mCx, mCy;                            // criterion is mC0 + mCx x + mCy y
+  
+ public:
+  
+ BasicRiskVectorUtility(double angle, double alpha)
+   : VectorUtility(angle, alpha), mOracle(alpha, mZAlpha), mCriterion(angle),
+    mC0(mCriterion(0.0,0.0)), mCx(mCriterion(1.0,0.0)-mC0), mCy(mCriterion(0.0,1.0)-mC0)
+    { std::clog << "UTIL: " << mOracle.name() << std::endl; }
+  
+  double operator()(double mu) const;
+  Derivatives derivatives (double mu) const;
+  void   evaluate (VectorLanes const& lanes, double const* mu, double *util) const;
+  bool   curve_weights (CurveWeights &w) const;
+  
+  double bidder_utility (double mu, double rejectValue, double noRejectValue) const;
+  double oracle_utility (double mu, double rejectValue, double noRejectValue) const;
 };
 
 
+
+//  Vector utilities at an angle; the risk utility picks the oracle from alpha as it is called
+
+typedef BasicRejectVectorUtility<AngleCriterion>            RejectVectorUtility;
+typedef BasicRiskVectorUtility<LevelOracle, AngleCriterion> RiskVectorUtility;
+
+//  Risk utility with the oracle for alpha fixed in its type, so that a solver given it
+//  calls the risk of the oracle directly
+VectorUtility*
+make_risk_vector_utility (double angle, double alpha);
+
+
 //  Matrix     Matrix     Matrix     Matrix     Matrix     Matrix     Matrix     Matrix     Matrix     Matrix     Matrix
 
 class MatrixUtility: public std::unary_function<double,double>
 {
  protected:
   double mAlpha, mBeta;
+  double mZAlpha, mZBeta;             // z_alpha of half the levels, found when they are set
   double mV00, mV01, mV10, mV11;      // 0 for not reject, 1 for reject
 
  public:
@@ -163,6 +352,9 @@ class MatrixUtility: public std::unary_function<double,double>
   double r_mu_beta  (double mu)           const;
   
   std::pair<double,double> reject_probabilities (double mu) const;    // prob rejecting for alpha and beta
+
+  // weights of the continuation values v00..v11, which depend on the order of alpha and beta
+  CurveWeights continuation_weights (double v00, double v01, double v10, double v11) const;
 }; 
 
 
@@ -183,10 +375,15 @@ class RejectMatrixUtility: public MatrixUtility
   std::string identifier() const                { return mCriterion.identifier(); }
 
   double operator()(double mu) const;
+  Derivatives derivatives (double mu) const;
 
   double row_utility (double mu, double v00, double v01, double v10, double v11) const;
   double col_utility (double mu, double v00, double v01, double v10, double v11) const;  
 
+  CurveWeights curve_weights () const;                                // operator()
+  CurveWeights row_weights (double v00, double v01, double v10, double v11) const;
+  CurveWeights col_weights (double v00, double v01, double v10, double v11) const;
+
   void   write_details_to_stream(double mu, std::ostream& os) const;
 }; 
 
@@ -207,12 +404,17 @@ class RiskMatrixUtility: public MatrixUtility
   std::string identifier() const                { return mCriterion.identifier(); }
   
   double operator()(double mu) const;
+  Derivatives derivatives (double mu) const;
   
   double negative_risk(double mu, double alpha) const;
 
   double row_utility (double mu, double v00, double v01, double v10, double v11) const;
   double col_utility (double mu, double v00, double v01, double v10, double v11) const;
 
+  CurveWeights curve_weights () const;                                // operator()
+  CurveWeights row_weights (double v00, double v01, double v10, double v11) const;
+  CurveWeights col_weights (double v00, double v01, double v10, double v11) const;
+
   void   write_details_to_stream(double mu, std::ostream& os) const;
   
 }; 
@@ -1,13 +1,35 @@
 #include "line_search.Template.h"
+#include "mean_search.Template.h"
 #include "utility.Template.h"
 #include "wealth.h"
 
 #include <iostream>
+#include <math.h>
 
 #include <ctime>
 #include <Eigen/Core>
  
 
+//  Two bumps, near mu=1.2 and at a larger mean; a utility with the two modes of the matrix
+//  utilities but whose modes can be placed, so that a warm start can begin in the lesser one
+
+class TwoBumps
+{
+  const double mHeight, mCenter;
+
+ public:
+  TwoBumps (double height, double center) : mHeight(height), mCenter(center) { }
+
+  double operator()(double mu) const { return derivatives(mu).value; }
+
+  Derivatives derivatives (double mu) const
+    { const double a (mu-1.2), b (mu-mCenter), ea (exp(-a*a/0.1)), eb (mHeight * exp(-b*b/0.5));
+      Derivatives d = { ea + eb, -20*a*ea - 4*b*eb, (400*a*a-20)*ea + (16*b*b-4)*eb };
+      return d;
+    }
+};
+
+
 int  main()
 {
 
@@ -76,6 +98,49 @@ int  main()
   }
   
 
+  if (true)
+  { std::cout << "\nTEST: curve weights reproduce matrix utilities (differences should be 0)." << std::endl;
+    RejectMatrixUtility<AngleCriterion> rejectU ( ac );
+    RiskMatrixUtility<AngleCriterion>   riskU   ( ac );
+    const double ab[2][2] = { {0.05, 0.01}, {0.002, 0.03} };     // alpha > beta, alpha < beta
+    for (int i=0; i<2; ++i)
+    { rejectU.set_constants(ab[i][0], ab[i][1], 0.3, 1.1, 0.7, 2.0);
+      riskU.set_constants  (ab[i][0], ab[i][1], 0.3, 1.1, 0.7, 2.0);
+      CurveWeights wReject (rejectU.curve_weights()), wRisk (riskU.curve_weights());
+      CurveWeights wRow (riskU.row_weights(0.3, 1.1, 0.7, 2.0)), wCol (rejectU.col_weights(0.3, 1.1, 0.7, 2.0));
+      for (double mu : {0.0, 0.5, 2.0, 5.0})
+      { double ra (reject_prob(mu,ab[i][0])), rb (reject_prob(mu,ab[i][1])), ka (risk(mu,ab[i][0])), kb (risk(mu,ab[i][1]));
+	std::cout << "TEST: alpha=" << ab[i][0] << " beta=" << ab[i][1] << " mu=" << mu
+		  << "  reject " << rejectU(mu) - wReject(ra,rb,ka,kb)
+		  << "  risk "   << riskU(mu)   - wRisk(ra,rb,ka,kb)
+		  << "  row "    << riskU.row_utility(mu, 0.3, 1.1, 0.7, 2.0) - wRow(ra,rb,ka,kb)
+		  << "  col "    << rejectU.col_utility(mu, 0.3, 1.1, 0.7, 2.0) - wCol(ra,rb,ka,kb) << std::endl;
+      }
+    }
+  }
+
+  if (true)
+  { std::cout << "\nTEST: analytic derivatives against central differences (differences should be near 0)." << std::endl;
+    const double h (1.0e-4);
+    RejectMatrixUtility<AngleCriterion> rejectU ( ac );
+    RiskMatrixUtility<AngleCriterion>   riskU   ( ac );
+    rejectU.set_constants(0.05, 0.01, 0.3, 1.1, 0.7, 2.0);
+    riskU.set_constants  (0.002, 0.03, 0.3, 1.1, 0.7, 2.0);
+    RejectVectorUtility rejectV (30, 0.05);
+    RiskVectorUtility   riskV   (30, 0.05);
+    rejectV.set_constants(0.02, 1.5, 0.5);
+    riskV.set_constants  (0.02, 1.5, 0.5);
+    for (double mu : {0.5, 1.0, 2.5, 4.0})
+    { Derivatives dr (rejectU.derivatives(mu)), dk (riskU.derivatives(mu)), vr (rejectV.derivatives(mu)), vk (riskV.derivatives(mu));
+      std::cout << "TEST: mu=" << mu
+		<< "  reject matrix " << dr.first - (rejectU(mu+h)-rejectU(mu-h))/(2*h) << " " << dr.second - (rejectU(mu+h)-2*rejectU(mu)+rejectU(mu-h))/(h*h)
+		<< "  risk matrix "   << dk.first - (riskU(mu+h)  -riskU(mu-h)  )/(2*h) << " " << dk.second - (riskU(mu+h)  -2*riskU(mu)  +riskU(mu-h)  )/(h*h)
+		<< "  reject vector " << vr.first - (rejectV(mu+h)-rejectV(mu-h))/(2*h) << " " << vr.second - (rejectV(mu+h)-2*rejectV(mu)+rejectV(mu-h))/(h*h)
+		<< "  risk vector "   << vk.first - (riskV(mu+h)  -riskV(mu-h)  )/(2*h) << " " << vk.second - (riskV(mu+h)  -2*riskV(mu)  +riskV(mu-h)  )/(h*h)
+		<< std::endl;
+    }
+  }
+
   if (true)
   { std::cout << "\nTEST: test reject matrix utility, and test maximizer with alpha=beta." << std::endl;
     double alpha (0.025);
@@ -101,6 +166,32 @@ int  main()
     }
   }
 
+  if (true)
+  { std::cout << "\nTEST: warm start from the optimum of the prior round agrees with the full search." << std::endl;
+    // the bump at large mu grows and moves round by round.  Round 1 starts near 1.2 with no rival,
+    // rounds 2-3 with the rival tracked on the other bump; in round 3 that bump is the higher,
+    // so the warm start begins in the lesser mode and must give way to the full search
+    const std::pair<double,double> interval (0.05, 10.0);
+    const Line_Search::GoldenSection golden (0.0001, interval, 0.5, 200);
+    for (int newton=0; newton<2; ++newton)
+    { MeanSearch warm (golden, 0.0001, interval, 0.5, 0.25, newton), full (golden, 0.0001, interval, 0.5, 0.0, newton);
+      double prior (0.0);
+      int rival (-1), differ (0);
+      for (int round=0; round<12; ++round)
+      { const TwoBumps f (0.6 + 0.15*round, 7.4 - 0.2*round);
+	const std::pair<double,double> w (warm.find_maximum(f, prior, prior, &rival)), g (full.find_maximum(f));
+	const bool same ((fabs(w.first - g.first) < 0.001) && (fabs(w.second - g.second) < 1.0e-8));
+	if (!same) ++differ;
+	std::cout << "TEST: " << (newton ? "newton" : "golden") << " round " << round << "  warm from " << prior
+		  << " -> " << w.first << " (" << w.second << ")   full -> " << g.first << " (" << g.second << ")"
+		  << (same ? "" : "   DIFFERS") << std::endl;
+	prior = w.first;
+      }
+      std::cout << "TEST: " << differ << " of 12 warm searches differ from the full search; " << warm.stats().evaluations
+		<< " evaluations against " << full.stats().evaluations << std::endl;
+    }
+  }
+
  
   if(false) 
   { std::cout << "\nTEST: testing maximizer function\n";
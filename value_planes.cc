@@ -0,0 +1,17 @@
+#include "value_planes.h"
+
+//     ValuePlanes     ValuePlanes     ValuePlanes     ValuePlanes     ValuePlanes     ValuePlanes
+
+template <class Scalar>
+Matrix
+BasicValuePlanes<Scalar>::matrix(Plane p) const
+{
+  Matrix m (mRows, mCols);
+  for (int r=0; r<mRows; ++r)
+    for (int c=0; c<mCols; ++c)
+      m(r,c) = (float) mData[nPlanes*(r*mCols+c)+p];
+  return m;
+}
+
+template class BasicValuePlanes<float>;
+template class BasicValuePlanes<double>;
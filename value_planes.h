@@ -0,0 +1,79 @@
+#ifndef _VALUE_PLANES_H_
+#define _VALUE_PLANES_H_
+
+#include "utility.h"     // Matrix
+
+#include <vector>
+
+/***********************************************************************************
+
+  Value state of the matrix recursion for one round.
+
+  The utility, row and column values and the optimal mean of a cell are stored
+  next to each other (16 bytes, four cells to a cache line), and cells are laid
+  out row by row, the order in which the solver walks them.  Interpolating the
+  three values at a position then touches two cache lines (rows r and r+1)
+  rather than six lines spread over three column-major matrices.
+
+  Values are stored as floats unless the solve asks for doubles (32 bytes to a
+  cell); the layout of the planes is the same for both.
+
+***********************************************************************************/
+
+class PlaneLayout
+{
+ public:
+  enum Plane { utility=0, row=1, col=2, mean=3 };
+  static const int nPlanes = 4;
+};
+
+
+template <class Scalar>
+class BasicValuePlanes : public PlaneLayout
+{
+  int mRows, mCols;
+  std::vector<Scalar> mData;
+
+ public:
+  typedef Scalar value_type;
+
+  BasicValuePlanes (int nRows, int nCols)
+    : mRows(nRows), mCols(nCols), mData(nPlanes*nRows*nCols, (Scalar) 0) { }
+
+  int rows()                               const { return mRows; }
+  int cols()                               const { return mCols; }
+  int stride()                             const { return nPlanes*mCols; }       // elements between rows
+
+  Scalar const* data()                     const { return &mData[0]; }
+  Scalar      * data()                           { return &mData[0]; }
+
+  Scalar operator()(int r, int c, Plane p) const { return mData[nPlanes*(r*mCols+c)+p]; }
+
+  void   set (int r, int c, double u, double rowValue, double colValue, double mu)
+    { Scalar *p (&mData[nPlanes*(r*mCols+c)]);
+      p[utility] = (Scalar) u; p[row] = (Scalar) rowValue; p[col] = (Scalar) colValue; p[mean] = (Scalar) mu;
+    }
+
+  template <class S>
+  void   assign (BasicValuePlanes<S> const& planes)                   // same size, converting the values
+    { S const* x (planes.data());
+      for (size_t i=0; i<mData.size(); ++i) mData[i] = (Scalar) x[i];
+    }
+
+  Matrix matrix(Plane p)                   const;    // one plane as a (column-major) matrix, for writing
+};
+
+typedef BasicValuePlanes<float>  ValuePlanes;
+typedef BasicValuePlanes<double> DoubleValuePlanes;
+
+
+//  Precision of the values of a solve: the type that stores them between rounds, and the
+//  type in which the interpolation of the stored values at the positions after a round
+//  is accumulated.  Float storage rounds every value to 24 bits each round; accumulating
+//  in double keeps the interpolation from adding to that rounding.
+
+struct FloatValues  { typedef float  Storage; typedef float  Accumulate; };
+struct MixedValues  { typedef float  Storage; typedef double Accumulate; };
+struct DoubleValues { typedef double Storage; typedef double Accumulate; };
+
+#endif
@@ -0,0 +1,99 @@
+/*
+  Cost of calling the vector utilities through VectorUtility in the search for means.
+
+  For each oracle (least squares, testimator, risk inflation) and the reject
+  utility, runs the search of the vector solver over a range of bids and
+  continuation values three ways: through a VectorUtility reference (virtual
+  calls), as the utility with the oracle chosen by its level (RiskVectorUtility),
+  and as the utility whose type fixes the oracle, which the search calls
+  directly and can inline.  Reports the time per search and per evaluation, and
+  checks that the three find the same optima.
+
+  Run with an argument to set the number of searches (default 20000).
+*/
+
+#include "bellman.h"
+#include "line_search.Template.h"
+#include "mean_search.Template.h"
+#include "utility.Template.h"
+
+#include <math.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+
+//  Searches for the optimal mean at each of n settings of the constants; returns seconds taken
+//  and accumulates the optima and the count of evaluations
+
+template <class Util>
+double
+time_searches (Util &utility, int n, std::vector<double> *optima, long *evaluations)
+{
+  MeanSearch search (make_mean_search(SolverOptions()));
+  optima->assign(n, 0.0);
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i=0; i<n; ++i)
+  { const double beta (0.001 + 0.2 * (i % 97) / 97.0);
+    const double rejectValue (0.5 * (i % 13)), noRejectValue (0.25 * (i % 7));
+    utility.set_constants(beta, rejectValue, noRejectValue);
+    (*optima)[i] = search.find_maximum(utility).first;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  *evaluations = search.stats().evaluations;
+  return std::chrono::duration<double>(t1-t0).count();
+}
+
+template <class Typed>
+void
+compare (std::string label, double alpha, int n)
+{
+  const double angle (100.0);
+  Typed typed (angle, alpha);
+  std::vector<double> virtualMeans, typedMeans;
+  long virtualEvals, typedEvals;
+  const double virtualSeconds (time_searches(static_cast<VectorUtility&>(typed), n, &virtualMeans, &virtualEvals));
+  const double typedSeconds   (time_searches(typed, n, &typedMeans, &typedEvals));
+  std::cout << "BENCH: " << std::setw(22) << std::left << label << std::right
+	    << std::setw(9) << std::setprecision(4) << 1.0e6*virtualSeconds/n << " us/search virtual"
+	    << std::setw(9) << 1.0e6*typedSeconds/n << " us/search typed"
+	    << std::setw(7) << std::setprecision(3) << virtualSeconds/typedSeconds << "x"
+	    << std::setw(8) << std::setprecision(4) << 1.0e9*typedSeconds/typedEvals << " ns/eval"
+	    << ((virtualMeans == typedMeans) ? "" : "   OPTIMA DIFFER") << std::endl;
+}
+
+template <class Typed>
+void
+compare_level (std::string label, double alpha, int n)             // oracle chosen by level against one fixed by type
+{
+  const double angle (100.0);
+  RiskVectorUtility level (angle, alpha);
+  Typed typed (angle, alpha);
+  std::vector<double> levelMeans, typedMeans;
+  long levelEvals, typedEvals;
+  const double levelSeconds (time_searches(level, n, &levelMeans, &levelEvals));
+  const double typedSeconds (time_searches(typed, n, &typedMeans, &typedEvals));
+  std::cout << "BENCH: " << std::setw(22) << std::left << label << std::right
+	    << std::setw(9) << std::setprecision(4) << 1.0e6*levelSeconds/n << " us/search by level"
+	    << std::setw(9) << 1.0e6*typedSeconds/n << " us/search typed"
+	    << std::setw(7) << std::setprecision(3) << levelSeconds/typedSeconds << "x"
+	    << ((levelMeans == typedMeans) ? "" : "   OPTIMA DIFFER") << std::endl;
+}
+
+
+int  main(int argc, char** argv)
+{
+  const int n = (argc > 1) ? atoi(argv[1]) : 20000;
+  std::cout << "BENCH: " << n << " searches for each utility" << std::endl;
+
+  compare<BasicRiskVectorUtility<LeastSquaresOracle, AngleCriterion>> ("risk, least squares", 0.0 , n);
+  compare<BasicRiskVectorUtility<TestimatorOracle, AngleCriterion>>   ("risk, testimator"   , 0.05, n);
+  compare<BasicRiskVectorUtility<RiskInflationOracle, AngleCriterion>>("risk, risk inflation", 1.0, n);
+  compare<RejectVectorUtility>                                         ("reject"             , 0.05, n);
+
+  compare_level<BasicRiskVectorUtility<LeastSquaresOracle, AngleCriterion>> ("risk, least squares", 0.0 , n);
+  compare_level<BasicRiskVectorUtility<TestimatorOracle, AngleCriterion>>   ("risk, testimator"   , 0.05, n);
+  compare_level<BasicRiskVectorUtility<RiskInflationOracle, AngleCriterion>>("risk, risk inflation", 1.0, n);
+  return 0;
+}